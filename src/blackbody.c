@@ -1,7 +1,52 @@
 ﻿#include "blackbody.h"
 #include <assert.h>
+#include <float.h>
 #include <math.h>
 
+// Beyond this exponent e^x - 1 rounds to e^x, so the ratio e^x/(e^x - 1) is exactly one
+#define PLANCK_LARGE_EXPONENT 37.0
+// Below this exponent e^x - 1 cancels noticeably and is computed with expm1 instead
+#define PLANCK_SMALL_EXPONENT 1.0
+// Shift applied to large exponents, along with e^(-shift)
+#define PLANCK_EXPONENT_SHIFT 88.0
+#define PLANCK_EXPONENT_UNSHIFT 6.0546018954011858e-39
+
+// Evaluates the exponent x = h*c/(λ*k*T) of Planck's law for λ in nanometers
+static double planck_exponent(const double lambda, const double T) {
+	return PLANCK * SPEED_OF_LIGHT / (lambda * BOLTZMANN * T) * 1.0e6;
+}
+
+// Evaluates the factor 2*h*c²/λ^5 of Planck's law for λ in nanometers, with the denominator scaled by the given factor
+static double planck_prefactor(const double lambda, const double scale) {
+	const double nominator = 2.0 * PLANCK * SPEED_OF_LIGHT * SPEED_OF_LIGHT;
+	return nominator * 1.0e27 / ((lambda * lambda) * (lambda * lambda) * lambda * scale);
+}
+
+/**
+ * Evaluates Planck's law without overflowing the exponential: for large exponents the radiance is computed
+ * as 2*h*c²/λ^5 * e^(-x), which degrades gracefully to zero, and for small ones e^x - 1 is computed with expm1
+ * to avoid cancellation at long wavelengths. Radiance below DBL_MIN is flushed to zero.
+ * If ratio is not NULL, it receives e^x/(e^x - 1) for the temperature derivative.
+ */
+static double planck_radiance(const double lambda, const double x, double* ratio) {
+	double radiance;
+	if(x > PLANCK_LARGE_EXPONENT) {
+		// e^(-x) is shifted by e^88 to keep it out of the (slow) denormal range all the way to the cutoff;
+		// the shift is exact for x up to 176 and costs at most an ulp above
+		const double eNegative = exp(PLANCK_EXPONENT_SHIFT - x);
+		radiance = eNegative > 0.0 ? planck_prefactor(lambda, 1.0) * PLANCK_EXPONENT_UNSHIFT * eNegative : 0.0;
+		if(ratio != NULL)
+			*ratio = 1.0;
+	} else {
+		// expm1 is considerably slower than exp, so it is only used where it matters
+		const double eMinusOne = x < PLANCK_SMALL_EXPONENT ? expm1(x) : exp(x) - 1.0;
+		radiance = planck_prefactor(lambda, eMinusOne);
+		if(ratio != NULL)
+			*ratio = 1.0 + 1.0 / eMinusOne;
+	}
+	return radiance < DBL_MIN ? 0.0 : radiance;
+}
+
 SpectralRadiance black_body_compute_sample(const Nanometer lambda, const Kelvin T) {
 	if(lambda.value < 0.0 || T.value < 0.0) {
 		const SpectralRadiance result = { 0.0 };
@@ -12,27 +57,128 @@ SpectralRadiance black_body_compute_sample(const Nanometer lambda, const Kelvin
 	// Given wavelengths instead of frequencies this leads to
 	// S_λ = 2*h*c²/(λ^5 * e^(h*c/(λ*k*T)) - 1)
 	//, which computes the amount of energy rediated per unit time and unit area into a unit of solid angle perpendicular to the surface.
-	const double ePart = exp(PLANCK * SPEED_OF_LIGHT / (lambda.value * BOLTZMANN * T.value) * 1.0e6);
-	const double nominator = 2.0 * PLANCK * SPEED_OF_LIGHT * SPEED_OF_LIGHT;
-	const double denominator = (lambda.value * lambda.value) * (lambda.value * lambda.value) * lambda.value * (ePart - 1.0);
-	const SpectralRadiance result = { nominator * 1.0e27 / denominator };
+	const SpectralRadiance result = { planck_radiance(lambda.value, planck_exponent(lambda.value, T.value), NULL) };
+	return result;
+}
+
+SpectralRadiance black_body_compute_sample_with_derivative(const Nanometer lambda, const Kelvin T,
+														   SpectralRadiance* derivative) {
+	if(lambda.value < 0.0 || T.value < 0.0) {
+		const SpectralRadiance result = { 0.0 };
+		if(derivative != NULL)
+			*derivative = result;
+		return result;
+	}
+	if(derivative == NULL)
+		return black_body_compute_sample(lambda, T);
+
+	// With x = h*c/(λ*k*T) the derivative of Planck's law with respect to temperature is
+	// dS_λ/dT = S_λ * x/T * e^x/(e^x - 1), so it reuses the exponential of the sample itself
+	const double exponent = planck_exponent(lambda.value, T.value);
+	double ratio;
+	const SpectralRadiance result = { planck_radiance(lambda.value, exponent, &ratio) };
+	// Vanishing radiance (e.g. for T = 0) has a vanishing derivative, even though x/T doesn't exist
+	derivative->value = result.value > 0.0 ? result.value * exponent / T.value * ratio : 0.0;
 	return result;
 }
 
 void black_body_compute_samples(const Nanometer start, const Nanometer end,
 								const size_t samples, const Kelvin temperature,
 								SpectralRadiance spectralRadiance[STATIC_SIZE(samples)]) {
+	const StridedView view = { spectralRadiance, (ptrdiff_t)sizeof(SpectralRadiance) };
+	black_body_compute_samples_strided(start, end, samples, temperature, view);
+}
+
+/**
+ * Computes how many leading samples of the grid have a radiance below DBL_MIN.
+ * Since 2*h*c²/λ^5 decreases with λ, any λ >= start radiates less than 2*h*c²/start^5 * e^(-x) * e^x/(e^x - 1).
+ * Below DBL_MIN this requires x > ln(2*h*c²/start^5) - ln(DBL_MIN) (plus a margin covering the ratio and rounding),
+ * and since x = h*c/(λ*k*T) that holds for every λ below h*c/(k*T*x_cut).
+ */
+static size_t underflow_cutoff(const Nanometer start, const Nanometer end, const size_t samples, const Kelvin T) {
+	if(samples < 2u || !(start.value > 0.0))
+		return 0u;
+	const double exponentCutoff = log(planck_prefactor(start.value, 1.0)) - log(DBL_MIN) + 1.0;
+	if(!(exponentCutoff > PLANCK_LARGE_EXPONENT) || !(exponentCutoff < INFINITY))
+		return 0u;
+
+	// The exponent is evaluated at λ = 1nm, yielding h*c/(k*T*x_cut) in nanometers; for T = 0 everything vanishes
+	const double lambdaCutoff = planck_exponent(1.0, T.value) / exponentCutoff;
+	if(!(lambdaCutoff > start.value))
+		return 0u;
+	if(!(lambdaCutoff <= end.value))
+		return samples;
+	const double position = ceil((lambdaCutoff - start.value) / (end.value - start.value) * (double)(samples - 1));
+	return position < (double)samples ? (size_t)position : samples;
+}
+
+void black_body_compute_samples_strided(const Nanometer start, const Nanometer end,
+										const size_t samples, const Kelvin temperature,
+										const StridedView spectralRadiance) {
 	if(start.value < 0.0 || end.value < 0.0 || start.value > end.value || temperature.value < 0.0)
 		return;
 
 	// We simply divide the sample domain into equally sized intervals
-	// and compute the samples at the boundaries of these intervals
-	for(size_t i = 0u; i < samples; ++i) {
+	// and compute the samples at the boundaries of these intervals.
+	// Samples below the underflow cutoff are known to vanish and skip the exponential altogether.
+	const size_t skipped = underflow_cutoff(start, end, samples, temperature);
+	for(size_t i = 0u; i < skipped; ++i)
+		strided_view_store(spectralRadiance, i, 0.0);
+	for(size_t i = skipped; i < samples; ++i) {
 		const Nanometer lambda = { start.value + (end.value - start.value) * (double)i / (double)(samples - 1) };
-		spectralRadiance[i] = black_body_compute_sample(lambda, temperature);
+		strided_view_store(spectralRadiance, i, black_body_compute_sample(lambda, temperature).value);
 	}
 }
 
+void black_body_compute_colors_strided(const size_t count, const Kelvin temperatures[STATIC_SIZE(count)],
+									   const CieXyzView xyz, const ColorRgbView rgb) {
+	SpectralRadiance spectralRadiance[CIE_XYZ_SAMPLES];
+	for(size_t i = 0u; i < count; ++i) {
+		// Invalid temperatures don't radiate
+		CieXyz color = { 0.0, 0.0, 0.0 };
+		if(temperatures[i].value >= 0.0) {
+			black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, temperatures[i], spectralRadiance);
+			color = cie_spectrum_to_xyz(spectralRadiance);
+		}
+		strided_view_store(xyz.x, i, color.x);
+		strided_view_store(xyz.y, i, color.y);
+		strided_view_store(xyz.z, i, color.z);
+
+		if(rgb.r.base != NULL || rgb.g.base != NULL || rgb.b.base != NULL) {
+			const ColorRgb linear = cie_xyz_to_rgb(color);
+			strided_view_store(rgb.r, i, linear.r);
+			strided_view_store(rgb.g, i, linear.g);
+			strided_view_store(rgb.b, i, linear.b);
+		}
+	}
+}
+
+BlackBodyColor black_body_compute_color_with_derivative(const Kelvin T) {
+	SpectralRadiance spectralRadiance[CIE_XYZ_SAMPLES];
+	SpectralRadiance derivative[CIE_XYZ_SAMPLES];
+
+	// Sample on the same grid as black_body_compute_samples does for the CIE range
+	const double start = CIE_XYZ_LAMBDA_START.value;
+	const double end = CIE_XYZ_LAMBDA_END.value;
+	for(size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i) {
+		const Nanometer lambda = { start + (end - start) * (double)i / (double)(CIE_XYZ_SAMPLES - 1) };
+		spectralRadiance[i] = black_body_compute_sample_with_derivative(lambda, T, &derivative[i]);
+	}
+
+	// Both the spectrum-to-XYZ and the XYZ-to-RGB conversions are linear,
+	// so the derivatives go through the same conversions as the values
+	BlackBodyColor color;
+	color.xyz = cie_spectrum_to_xyz(spectralRadiance);
+	color.dXyz = cie_spectrum_to_xyz(derivative);
+	color.rgb = cie_xyz_to_rgb(color.xyz);
+	color.dRgb = cie_xyz_to_rgb(color.dXyz);
+	return color;
+}
+
+unsigned black_body_abi_version(void) {
+	return ((unsigned)BLACKBODY_VERSION_MAJOR << 16u) | (unsigned)BLACKBODY_VERSION_MINOR;
+}
+
 Nanometer black_body_compute_peak_wavelength(const Kelvin T) {
 	if(T.value < 0.0) {
 		const Nanometer result = { 0.0 };
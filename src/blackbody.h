@@ -1,6 +1,8 @@
 ﻿#ifndef BLACKBODY_BLACKBODY_H_
 #define BLACKBODY_BLACKBODY_H_
 
+#include "cie_xyz.h"
+#include "export.h"
 #include "units.h"
 #include "util.h"
 
@@ -10,22 +12,65 @@ extern "C" {
 
 #include <stddef.h>
 
+    // Color of a black body along with its derivative with respect to temperature
+    typedef struct BlackBodyColor {
+        CieXyz xyz;
+        CieXyz dXyz;    // d(XYZ)/dT [1/K]
+        ColorRgb rgb;
+        ColorRgb dRgb;  // d(RGB)/dT [1/K]
+    } BlackBodyColor;
+
     /**
      * Takes a wavelength and temperature and computes the black-body radiation
      * per unit time, area, and solid angle perpendicular to the surface.
+     * The exponential never overflows; radiance too small for a normal double is returned as zero.
+     */
+    BLACKBODY_API SpectralRadiance black_body_compute_sample(const Nanometer wavelength, const Kelvin T);
+
+    /**
+     * Computes the same sample as black_body_compute_sample and additionally writes the
+     * analytic derivative of Planck's law with respect to temperature (dB/dT) to derivative.
+     * If derivative is NULL, only the sample is computed.
+     */
+    BLACKBODY_API SpectralRadiance black_body_compute_sample_with_derivative(const Nanometer wavelength, const Kelvin T,
+                                                                             SpectralRadiance* derivative);
+
+    /**
+     * Computes N samples of black-body radiation between two given wavelengths.
+     * Leading samples whose radiance is known to vanish (see black_body_compute_sample) are skipped
+     * without evaluating the exponential, which makes low-temperature spectra cheap.
+     */
+    BLACKBODY_API void black_body_compute_samples(const Nanometer start, const Nanometer end,
+                                                  const size_t samples, const Kelvin temperature,
+                                                  SpectralRadiance spectralRadiance[STATIC_SIZE(samples)]);
+
+    // Same as black_body_compute_samples, but writes the i-th sample to the given view
+    BLACKBODY_API void black_body_compute_samples_strided(const Nanometer start, const Nanometer end,
+                                                          const size_t samples, const Kelvin temperature,
+                                                          const StridedView spectralRadiance);
+
+    /**
+     * Computes the XYZ and RGB colors of count black bodies (sampled over the CIE range) and writes
+     * the i-th color's channels to the given views; channels with a NULL base are skipped.
+     */
+    BLACKBODY_API void black_body_compute_colors_strided(const size_t count, const Kelvin temperatures[STATIC_SIZE(count)],
+                                                         const CieXyzView xyz, const ColorRgbView rgb);
+
+    /**
+     * Computes the XYZ and RGB color of the black-body spectrum sampled over the CIE range
+     * (see CIE_XYZ_LAMBDA_START and CIE_XYZ_LAMBDA_END) together with their temperature derivatives.
+     * Each spectral sample and its derivative share a single evaluation of the exponential.
      */
-    SpectralRadiance black_body_compute_sample(const Nanometer wavelength, const Kelvin T);
+    BLACKBODY_API BlackBodyColor black_body_compute_color_with_derivative(const Kelvin T);
 
-    // Computes N samples of black-body radiation between two given wavelengths
-    void black_body_compute_samples(const Nanometer start, const Nanometer end,
-                                    const size_t samples, const Kelvin temperature,
-                                    SpectralRadiance spectralRadiance[STATIC_SIZE(samples)]);
+    // Returns the ABI version of the library as (BLACKBODY_VERSION_MAJOR << 16) | BLACKBODY_VERSION_MINOR
+    BLACKBODY_API unsigned black_body_abi_version(void);
 
     // Computes the peak wavelength and spectral radiance for the given temperature
-    Nanometer black_body_compute_peak_wavelength(const Kelvin T);
+    BLACKBODY_API Nanometer black_body_compute_peak_wavelength(const Kelvin T);
 
 #ifdef __cplusplus
-} extern "C"
+} // extern "C"
 #endif // __cplusplus
 
 #endif // BLACKBODY_BLACKBODY_H_
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "cie_xyz.h"
+#include <math.h>
 
 ColorRgb cie_xyz_to_rgb(const CieXyz xyz) {
     // The conversion matrix is taken from http://brucelindbloom.com/index.html?Eqn_RGB_XYZ_Matrix.html.
@@ -11,29 +12,389 @@ ColorRgb cie_xyz_to_rgb(const CieXyz xyz) {
 	return rgb;
 }
 
-CieXyz cie_spectrum_to_xyz(SpectralRadiance spectralRadiance[STATIC_SIZE(CIE_XYZ_SAMPLES)]) {
+// SSE2 is part of every x86-64 target, so the reduction can use it without runtime dispatch
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CIE_XYZ_USE_SSE2
+#endif // __SSE2__
+
+// Number of independent accumulators per channel. They break up the dependency chain of the
+// additions; lane l sums up the samples i with i % CIE_XYZ_LANES == l in either code path.
+#define CIE_XYZ_LANES 4u
+
+// The SSE2 reductions finish with a single group of lanes that covers the last three samples and the padding
+#if CIE_XYZ_SAMPLES % CIE_XYZ_LANES != 3u || CIE_XYZ_PADDED_SAMPLES != CIE_XYZ_SAMPLES + 1u
+#error "The padding of the response tables doesn't match the lanes of the reduction"
+#endif
+
+CieXyz cie_spectrum_to_xyz(const SpectralRadiance spectralRadiance[STATIC_SIZE(CIE_XYZ_SAMPLES)]) {
     // To convert the spectrum to XYZ, we first have to multiply the spectrum
     // with the response spectrum of CIE X, Y, and Z. Summing them up gives
     // us the non-normalized response values of the three channels.
     // The normalization factor is the integrated response over the wavelength interval
     // of the Y channel.
-    CieXyz xyz = { 0.0, 0.0, 0.0 };
+    double x[CIE_XYZ_LANES] = { 0.0 };
+    double y[CIE_XYZ_LANES] = { 0.0 };
+    double z[CIE_XYZ_LANES] = { 0.0 };
+    size_t i = 0u;
+#ifdef CIE_XYZ_USE_SSE2
+    // The response tables are aligned, the spectrum may not be
+    __m128d x01 = _mm_setzero_pd(), x23 = _mm_setzero_pd();
+    __m128d y01 = _mm_setzero_pd(), y23 = _mm_setzero_pd();
+    __m128d z01 = _mm_setzero_pd(), z23 = _mm_setzero_pd();
+    for(; i + CIE_XYZ_LANES <= CIE_XYZ_SAMPLES; i += CIE_XYZ_LANES) {
+        const __m128d s01 = _mm_loadu_pd(&spectralRadiance[i].value);
+        const __m128d s23 = _mm_loadu_pd(&spectralRadiance[i + 2u].value);
+        x01 = _mm_add_pd(x01, _mm_mul_pd(_mm_load_pd(&CIE_X[i]), s01));
+        x23 = _mm_add_pd(x23, _mm_mul_pd(_mm_load_pd(&CIE_X[i + 2u]), s23));
+        y01 = _mm_add_pd(y01, _mm_mul_pd(_mm_load_pd(&CIE_Y[i]), s01));
+        y23 = _mm_add_pd(y23, _mm_mul_pd(_mm_load_pd(&CIE_Y[i + 2u]), s23));
+        z01 = _mm_add_pd(z01, _mm_mul_pd(_mm_load_pd(&CIE_Z[i]), s01));
+        z23 = _mm_add_pd(z23, _mm_mul_pd(_mm_load_pd(&CIE_Z[i + 2u]), s23));
+    }
+    {
+        // The last group of lanes reaches into the zero padding of the tables; the spectrum has no sample
+        // there, so it is loaded as zero and the padded lane adds an exact zero
+        const __m128d s01 = _mm_loadu_pd(&spectralRadiance[i].value);
+        const __m128d s2 = _mm_load_sd(&spectralRadiance[i + 2u].value);
+        x01 = _mm_add_pd(x01, _mm_mul_pd(_mm_load_pd(&CIE_X[i]), s01));
+        x23 = _mm_add_pd(x23, _mm_mul_pd(_mm_load_pd(&CIE_X[i + 2u]), s2));
+        y01 = _mm_add_pd(y01, _mm_mul_pd(_mm_load_pd(&CIE_Y[i]), s01));
+        y23 = _mm_add_pd(y23, _mm_mul_pd(_mm_load_pd(&CIE_Y[i + 2u]), s2));
+        z01 = _mm_add_pd(z01, _mm_mul_pd(_mm_load_pd(&CIE_Z[i]), s01));
+        z23 = _mm_add_pd(z23, _mm_mul_pd(_mm_load_pd(&CIE_Z[i + 2u]), s2));
+    }
+    _mm_storeu_pd(&x[0u], x01);
+    _mm_storeu_pd(&x[2u], x23);
+    _mm_storeu_pd(&y[0u], y01);
+    _mm_storeu_pd(&y[2u], y23);
+    _mm_storeu_pd(&z[0u], z01);
+    _mm_storeu_pd(&z[2u], z23);
+#else
+    for(; i + CIE_XYZ_LANES <= CIE_XYZ_SAMPLES; i += CIE_XYZ_LANES) {
+        for(size_t l = 0u; l < CIE_XYZ_LANES; ++l) {
+            x[l] += CIE_X[i + l] * spectralRadiance[i + l].value;
+            y[l] += CIE_Y[i + l] * spectralRadiance[i + l].value;
+            z[l] += CIE_Z[i + l] * spectralRadiance[i + l].value;
+        }
+    }
+    for(size_t l = 0u; i < CIE_XYZ_SAMPLES; ++i, ++l) {
+        x[l] += CIE_X[i] * spectralRadiance[i].value;
+        y[l] += CIE_Y[i] * spectralRadiance[i].value;
+        z[l] += CIE_Z[i] * spectralRadiance[i].value;
+    }
+#endif // CIE_XYZ_USE_SSE2
+
+    const double scale = (double)(CIE_XYZ_LAMBDA_END.value - CIE_XYZ_LAMBDA_START.value) / (CIE_Y_INTEGRAL * (double)CIE_XYZ_SAMPLES);
+    const CieXyz xyz = {
+        ((x[0] + x[1]) + (x[2] + x[3])) * scale,
+        ((y[0] + y[1]) + (y[2] + y[3])) * scale,
+        ((z[0] + z[1]) + (z[2] + z[3])) * scale
+    };
+    return xyz;
+}
+
+// Adds value to the running sum and collects the lost low-order bits in compensation (Neumaier)
+static void compensated_add(double* sum, double* compensation, const double value) {
+    const double t = *sum + value;
+    if(fabs(*sum) >= fabs(value))
+        *compensation += (*sum - t) + value;
+    else
+        *compensation += (value - t) + *sum;
+    *sum = t;
+}
+
+CieXyz cie_spectrum_to_xyz_compensated(const SpectralRadiance spectralRadiance[STATIC_SIZE(CIE_XYZ_SAMPLES)]) {
+    double x = 0.0, y = 0.0, z = 0.0;
+    double cx = 0.0, cy = 0.0, cz = 0.0;
     for(size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i) {
-        xyz.x += CIE_X[i] * spectralRadiance[i].value;
-        xyz.y += CIE_Y[i] * spectralRadiance[i].value;
-        xyz.z += CIE_Z[i] * spectralRadiance[i].value;
+        compensated_add(&x, &cx, CIE_X[i] * spectralRadiance[i].value);
+        compensated_add(&y, &cy, CIE_Y[i] * spectralRadiance[i].value);
+        compensated_add(&z, &cz, CIE_Z[i] * spectralRadiance[i].value);
     }
+
     const double scale = (double)(CIE_XYZ_LAMBDA_END.value - CIE_XYZ_LAMBDA_START.value) / (CIE_Y_INTEGRAL * (double)CIE_XYZ_SAMPLES);
+    const CieXyz xyz = { (x + cx) * scale, (y + cy) * scale, (z + cz) * scale };
+    return xyz;
+}
+
+// Finds the index range outside of which the response is zero
+static CieExtent find_extent(const double response[], const size_t samples) {
+    CieExtent extent = { 0u, samples };
+    while(extent.begin < extent.end && response[extent.begin] == 0.0)
+        ++extent.begin;
+    while(extent.end > extent.begin && response[extent.end - 1u] == 0.0)
+        --extent.end;
+    return extent;
+}
+
+void cie_table_init(CieTable* table, const CieResolution resolution) {
+    const size_t stride = (size_t)resolution;
+    table->resolution = resolution;
+    table->samples = (CIE_XYZ_SAMPLES - 1u) / stride + 1u;
+
+    // Every coarse sample j stands in for the 1nm samples within one step of it, weighted by
+    // their distance (the hat function of linear interpolation between coarse samples)
+    for(size_t j = 0u; j < table->samples; ++j) {
+        const size_t center = j * stride;
+        const size_t begin = center >= stride ? center - stride + 1u : 0u;
+        const size_t end = center + stride <= CIE_XYZ_SAMPLES ? center + stride : CIE_XYZ_SAMPLES;
+        double x = 0.0, y = 0.0, z = 0.0;
+        for(size_t i = begin; i < end; ++i) {
+            const double distance = (double)(i > center ? i - center : center - i);
+            const double weight = 1.0 - distance / (double)stride;
+            x += weight * CIE_X[i];
+            y += weight * CIE_Y[i];
+            z += weight * CIE_Z[i];
+        }
+        table->x[j] = x;
+        table->y[j] = y;
+        table->z[j] = z;
+    }
+
+    table->xExtent = find_extent(table->x, table->samples);
+    table->yExtent = find_extent(table->y, table->samples);
+    table->zExtent = find_extent(table->z, table->samples);
+}
+
+// Sums up response times spectrum over the given range
+static double integrate_range(const double response[], const SpectralRadiance spectralRadiance[],
+                              const size_t begin, const size_t end) {
+    double sum = 0.0;
+    for(size_t i = begin; i < end; ++i)
+        sum += response[i] * spectralRadiance[i].value;
+    return sum;
+}
+
+CieXyz cie_spectrum_to_xyz_table(const CieTable* table, const SpectralRadiance spectralRadiance[]) {
+    // The coarse weights already account for the samples they replace, so
+    // the normalization is the same as for the 1nm data
+    const double scale = (double)(CIE_XYZ_LAMBDA_END.value - CIE_XYZ_LAMBDA_START.value) / (CIE_Y_INTEGRAL * (double)CIE_XYZ_SAMPLES);
+
+    // Where all channels respond they share one pass over the spectrum;
+    // the remaining parts of each channel's extent are summed up separately
+    size_t begin = table->xExtent.begin > table->yExtent.begin ? table->xExtent.begin : table->yExtent.begin;
+    begin = begin > table->zExtent.begin ? begin : table->zExtent.begin;
+    size_t end = table->xExtent.end < table->yExtent.end ? table->xExtent.end : table->yExtent.end;
+    end = end < table->zExtent.end ? end : table->zExtent.end;
+    if(end < begin)
+        end = begin;
+
+    CieXyz xyz = { 0.0, 0.0, 0.0 };
+    for(size_t i = begin; i < end; ++i) {
+        xyz.x += table->x[i] * spectralRadiance[i].value;
+        xyz.y += table->y[i] * spectralRadiance[i].value;
+        xyz.z += table->z[i] * spectralRadiance[i].value;
+    }
+    xyz.x += integrate_range(table->x, spectralRadiance, table->xExtent.begin, begin)
+        + integrate_range(table->x, spectralRadiance, end, table->xExtent.end);
+    xyz.y += integrate_range(table->y, spectralRadiance, table->yExtent.begin, begin)
+        + integrate_range(table->y, spectralRadiance, end, table->yExtent.end);
+    xyz.z += integrate_range(table->z, spectralRadiance, table->zExtent.begin, begin)
+        + integrate_range(table->z, spectralRadiance, end, table->zExtent.end);
+
     xyz.x *= scale;
     xyz.y *= scale;
     xyz.z *= scale;
-
     return xyz;
 }
 
+// Number of spectra converted together: with the four lanes of each channel this keeps 24 sums in flight
+// (12 SSE2 registers), which leaves enough registers for the shared response values and the spectra.
+// It isn't tunable; spectra_block_to_xyz is written out for exactly two spectra.
+#define CIE_SPECTRA_BLOCK 2u
+#if CIE_SPECTRA_BLOCK != 2u
+#error "spectra_block_to_xyz converts exactly two spectra"
+#endif
+
+// The i-th sample of a spectrum, weighted by the emissivity if there is one
+static inline double emitted_sample(const SpectralRadiance* s, const double* e, const size_t i) {
+    return e != NULL ? s[i].value * e[i] : s[i].value;
+}
+
+#ifdef CIE_XYZ_USE_SSE2
+// The samples i and i + 1 of a spectrum, weighted by the emissivity if there is one
+static inline __m128d emitted_samples(const SpectralRadiance* s, const double* e, const size_t i) {
+    const __m128d samples = _mm_loadu_pd(&s[i].value);
+    return e != NULL ? _mm_mul_pd(samples, _mm_loadu_pd(&e[i])) : samples;
+}
+
+// The sample i of a spectrum in the lower half, with the upper half zero
+static inline __m128d emitted_last_sample(const SpectralRadiance* s, const double* e, const size_t i) {
+    const __m128d sample = _mm_load_sd(&s[i].value);
+    return e != NULL ? _mm_mul_pd(sample, _mm_load_sd(&e[i])) : sample;
+}
+#endif // CIE_XYZ_USE_SSE2
+
+/**
+ * Sums up the response-weighted samples of two spectra with the same lanes and reduction order as cie_spectrum_to_xyz.
+ * The samples are multiplied by the spectral emissivities e0 and e1 as they are loaded, unless those are NULL.
+ * Z is only visited below zEnd (a multiple of CIE_XYZ_LANES), past which its response is zero.
+ */
+static inline void spectra_block_to_xyz(const SpectralRadiance* s0, const double* e0,
+                                        const SpectralRadiance* s1, const double* e1, const size_t zEnd,
+                                        double sums[CIE_SPECTRA_BLOCK][3u]) {
+    double x[CIE_SPECTRA_BLOCK][CIE_XYZ_LANES] = { { 0.0 } };
+    double y[CIE_SPECTRA_BLOCK][CIE_XYZ_LANES] = { { 0.0 } };
+    double z[CIE_SPECTRA_BLOCK][CIE_XYZ_LANES] = { { 0.0 } };
+    size_t i = 0u;
+#ifdef CIE_XYZ_USE_SSE2
+    __m128d ax01 = _mm_setzero_pd(), ax23 = _mm_setzero_pd(), bx01 = _mm_setzero_pd(), bx23 = _mm_setzero_pd();
+    __m128d ay01 = _mm_setzero_pd(), ay23 = _mm_setzero_pd(), by01 = _mm_setzero_pd(), by23 = _mm_setzero_pd();
+    __m128d az01 = _mm_setzero_pd(), az23 = _mm_setzero_pd(), bz01 = _mm_setzero_pd(), bz23 = _mm_setzero_pd();
+    for(; i + CIE_XYZ_LANES <= zEnd; i += CIE_XYZ_LANES) {
+        // Every response value is loaded once for both spectra
+        const __m128d a01 = emitted_samples(s0, e0, i);
+        const __m128d a23 = emitted_samples(s0, e0, i + 2u);
+        const __m128d b01 = emitted_samples(s1, e1, i);
+        const __m128d b23 = emitted_samples(s1, e1, i + 2u);
+        const __m128d cx01 = _mm_load_pd(&CIE_X[i]);
+        const __m128d cx23 = _mm_load_pd(&CIE_X[i + 2u]);
+        ax01 = _mm_add_pd(ax01, _mm_mul_pd(cx01, a01));
+        ax23 = _mm_add_pd(ax23, _mm_mul_pd(cx23, a23));
+        bx01 = _mm_add_pd(bx01, _mm_mul_pd(cx01, b01));
+        bx23 = _mm_add_pd(bx23, _mm_mul_pd(cx23, b23));
+        const __m128d cy01 = _mm_load_pd(&CIE_Y[i]);
+        const __m128d cy23 = _mm_load_pd(&CIE_Y[i + 2u]);
+        ay01 = _mm_add_pd(ay01, _mm_mul_pd(cy01, a01));
+        ay23 = _mm_add_pd(ay23, _mm_mul_pd(cy23, a23));
+        by01 = _mm_add_pd(by01, _mm_mul_pd(cy01, b01));
+        by23 = _mm_add_pd(by23, _mm_mul_pd(cy23, b23));
+        const __m128d cz01 = _mm_load_pd(&CIE_Z[i]);
+        const __m128d cz23 = _mm_load_pd(&CIE_Z[i + 2u]);
+        az01 = _mm_add_pd(az01, _mm_mul_pd(cz01, a01));
+        az23 = _mm_add_pd(az23, _mm_mul_pd(cz23, a23));
+        bz01 = _mm_add_pd(bz01, _mm_mul_pd(cz01, b01));
+        bz23 = _mm_add_pd(bz23, _mm_mul_pd(cz23, b23));
+    }
+    // Beyond its extent Z only ever adds zeros, which leave the sums unchanged
+    for(; i + CIE_XYZ_LANES <= CIE_XYZ_SAMPLES; i += CIE_XYZ_LANES) {
+        const __m128d a01 = emitted_samples(s0, e0, i);
+        const __m128d a23 = emitted_samples(s0, e0, i + 2u);
+        const __m128d b01 = emitted_samples(s1, e1, i);
+        const __m128d b23 = emitted_samples(s1, e1, i + 2u);
+        const __m128d cx01 = _mm_load_pd(&CIE_X[i]);
+        const __m128d cx23 = _mm_load_pd(&CIE_X[i + 2u]);
+        ax01 = _mm_add_pd(ax01, _mm_mul_pd(cx01, a01));
+        ax23 = _mm_add_pd(ax23, _mm_mul_pd(cx23, a23));
+        bx01 = _mm_add_pd(bx01, _mm_mul_pd(cx01, b01));
+        bx23 = _mm_add_pd(bx23, _mm_mul_pd(cx23, b23));
+        const __m128d cy01 = _mm_load_pd(&CIE_Y[i]);
+        const __m128d cy23 = _mm_load_pd(&CIE_Y[i + 2u]);
+        ay01 = _mm_add_pd(ay01, _mm_mul_pd(cy01, a01));
+        ay23 = _mm_add_pd(ay23, _mm_mul_pd(cy23, a23));
+        by01 = _mm_add_pd(by01, _mm_mul_pd(cy01, b01));
+        by23 = _mm_add_pd(by23, _mm_mul_pd(cy23, b23));
+    }
+    {
+        // The last group of lanes reaches into the zero padding of the tables (see cie_spectrum_to_xyz)
+        const __m128d a01 = emitted_samples(s0, e0, i);
+        const __m128d a2 = emitted_last_sample(s0, e0, i + 2u);
+        const __m128d b01 = emitted_samples(s1, e1, i);
+        const __m128d b2 = emitted_last_sample(s1, e1, i + 2u);
+        ax01 = _mm_add_pd(ax01, _mm_mul_pd(_mm_load_pd(&CIE_X[i]), a01));
+        ax23 = _mm_add_pd(ax23, _mm_mul_pd(_mm_load_pd(&CIE_X[i + 2u]), a2));
+        bx01 = _mm_add_pd(bx01, _mm_mul_pd(_mm_load_pd(&CIE_X[i]), b01));
+        bx23 = _mm_add_pd(bx23, _mm_mul_pd(_mm_load_pd(&CIE_X[i + 2u]), b2));
+        ay01 = _mm_add_pd(ay01, _mm_mul_pd(_mm_load_pd(&CIE_Y[i]), a01));
+        ay23 = _mm_add_pd(ay23, _mm_mul_pd(_mm_load_pd(&CIE_Y[i + 2u]), a2));
+        by01 = _mm_add_pd(by01, _mm_mul_pd(_mm_load_pd(&CIE_Y[i]), b01));
+        by23 = _mm_add_pd(by23, _mm_mul_pd(_mm_load_pd(&CIE_Y[i + 2u]), b2));
+        if(i < zEnd) {
+            az01 = _mm_add_pd(az01, _mm_mul_pd(_mm_load_pd(&CIE_Z[i]), a01));
+            az23 = _mm_add_pd(az23, _mm_mul_pd(_mm_load_pd(&CIE_Z[i + 2u]), a2));
+            bz01 = _mm_add_pd(bz01, _mm_mul_pd(_mm_load_pd(&CIE_Z[i]), b01));
+            bz23 = _mm_add_pd(bz23, _mm_mul_pd(_mm_load_pd(&CIE_Z[i + 2u]), b2));
+        }
+    }
+    _mm_storeu_pd(&x[0u][0u], ax01);
+    _mm_storeu_pd(&x[0u][2u], ax23);
+    _mm_storeu_pd(&x[1u][0u], bx01);
+    _mm_storeu_pd(&x[1u][2u], bx23);
+    _mm_storeu_pd(&y[0u][0u], ay01);
+    _mm_storeu_pd(&y[0u][2u], ay23);
+    _mm_storeu_pd(&y[1u][0u], by01);
+    _mm_storeu_pd(&y[1u][2u], by23);
+    _mm_storeu_pd(&z[0u][0u], az01);
+    _mm_storeu_pd(&z[0u][2u], az23);
+    _mm_storeu_pd(&z[1u][0u], bz01);
+    _mm_storeu_pd(&z[1u][2u], bz23);
+#else
+    for(; i + CIE_XYZ_LANES <= CIE_XYZ_SAMPLES; i += CIE_XYZ_LANES) {
+        for(size_t l = 0u; l < CIE_XYZ_LANES; ++l) {
+            const double cx = CIE_X[i + l], cy = CIE_Y[i + l];
+            const double a = emitted_sample(s0, e0, i + l), b = emitted_sample(s1, e1, i + l);
+            x[0u][l] += cx * a;
+            x[1u][l] += cx * b;
+            y[0u][l] += cy * a;
+            y[1u][l] += cy * b;
+            if(i < zEnd) {
+                z[0u][l] += CIE_Z[i + l] * a;
+                z[1u][l] += CIE_Z[i + l] * b;
+            }
+        }
+    }
+    for(size_t l = 0u; i < CIE_XYZ_SAMPLES; ++i, ++l) {
+        const double a = emitted_sample(s0, e0, i), b = emitted_sample(s1, e1, i);
+        x[0u][l] += CIE_X[i] * a;
+        x[1u][l] += CIE_X[i] * b;
+        y[0u][l] += CIE_Y[i] * a;
+        y[1u][l] += CIE_Y[i] * b;
+        if(i < zEnd) {
+            z[0u][l] += CIE_Z[i] * a;
+            z[1u][l] += CIE_Z[i] * b;
+        }
+    }
+#endif // CIE_XYZ_USE_SSE2
+
+    for(size_t b = 0u; b < CIE_SPECTRA_BLOCK; ++b) {
+        sums[b][0u] = (x[b][0] + x[b][1]) + (x[b][2] + x[b][3]);
+        sums[b][1u] = (y[b][0] + y[b][1]) + (y[b][2] + y[b][3]);
+        sums[b][2u] = (z[b][0] + z[b][1]) + (z[b][2] + z[b][3]);
+    }
+}
+
+void cie_spectra_to_xyz_strided(const size_t count, const SpectralRadiance spectra[],
+                                const double emissivity[], const CieXyzView xyz) {
+    const double scale = (double)(CIE_XYZ_LAMBDA_END.value - CIE_XYZ_LAMBDA_START.value) / (CIE_Y_INTEGRAL * (double)CIE_XYZ_SAMPLES);
+
+    // Z vanishes above ~660nm; skipping its zero tail (rounded up to whole lanes) saves an eighth of the work
+    // without changing any sum, as long as the spectra are finite
+    const CieExtent zExtent = find_extent(CIE_Z, CIE_XYZ_SAMPLES);
+    const size_t zEnd = (zExtent.end + CIE_XYZ_LANES - 1u) / CIE_XYZ_LANES * CIE_XYZ_LANES;
+
+    for(size_t n = 0u; n < count; n += CIE_SPECTRA_BLOCK) {
+        // A remaining spectrum that doesn't fill a whole block is paired with itself
+        const size_t m = n + 1u < count ? n + 1u : n;
+        double sums[CIE_SPECTRA_BLOCK][3u];
+        // Separate calls, so that the kernel gets inlined without the emissivity checks when there is none
+        if(emissivity != NULL) {
+            spectra_block_to_xyz(&spectra[n * CIE_XYZ_SAMPLES], &emissivity[n * CIE_XYZ_SAMPLES],
+                                 &spectra[m * CIE_XYZ_SAMPLES], &emissivity[m * CIE_XYZ_SAMPLES], zEnd, sums);
+        } else {
+            spectra_block_to_xyz(&spectra[n * CIE_XYZ_SAMPLES], NULL, &spectra[m * CIE_XYZ_SAMPLES], NULL, zEnd, sums);
+        }
+        for(size_t b = 0u; b < CIE_SPECTRA_BLOCK && n + b < count; ++b) {
+            strided_view_store(xyz.x, n + b, sums[b][0u] * scale);
+            strided_view_store(xyz.y, n + b, sums[b][1u] * scale);
+            strided_view_store(xyz.z, n + b, sums[b][2u] * scale);
+        }
+    }
+}
+
+void cie_spectra_to_xyz(const size_t count, const SpectralRadiance spectra[],
+                        const double emissivity[], CieXyz xyz[STATIC_SIZE(count)]) {
+    const CieXyzView view = {
+        { &xyz[0].x, (ptrdiff_t)sizeof(CieXyz) },
+        { &xyz[0].y, (ptrdiff_t)sizeof(CieXyz) },
+        { &xyz[0].z, (ptrdiff_t)sizeof(CieXyz) }
+    };
+    cie_spectra_to_xyz_strided(count, spectra, emissivity, view);
+}
+
 // Spectrum response data for X Y Z at wavelengths 380nm, 381nm, 382nm, ..., 829nm, 830nm
 // The values are taken from PBRT
-const double CIE_X[] = {
+ALIGNED(CIE_XYZ_ALIGNMENT) const double CIE_X[CIE_XYZ_PADDED_SAMPLES] = {
     0.0001299000,   0.0001458470,   0.0001638021,   0.0001840037,
     0.0002066902,   0.0002321000,   0.0002607280,   0.0002930750,
     0.0003293880,   0.0003699140,   0.0004149000,   0.0004641587,
@@ -154,9 +515,7 @@ const double CIE_X[] = {
     0.000001439440, 0.000001341977, 0.000001251141
 };
 
-#define CIE_SAMPLE_SIZE sizeof(CIE_X) / sizeof(CIE_X[0])
-
-const double CIE_Y[CIE_SAMPLE_SIZE] = {
+ALIGNED(CIE_XYZ_ALIGNMENT) const double CIE_Y[CIE_XYZ_PADDED_SAMPLES] = {
     0.000003917000,  0.000004393581,  0.000004929604,  0.000005532136,
     0.000006208245,  0.000006965000,  0.000007813219,  0.000008767336,
     0.000009839844,  0.00001104323,   0.00001239000,   0.00001388641,
@@ -277,7 +636,7 @@ const double CIE_Y[CIE_SAMPLE_SIZE] = {
     0.0000005198080, 0.0000004846123, 0.0000004518100
 };
 
-const double CIE_Z[CIE_SAMPLE_SIZE] = {
+ALIGNED(CIE_XYZ_ALIGNMENT) const double CIE_Z[CIE_XYZ_PADDED_SAMPLES] = {
     0.0006061000,    0.0006808792,    0.0007651456,    0.0008600124,
     0.0009665928,    0.001086000,     0.001220586,     0.001372729,
     0.001543579,     0.001734286,     0.001946000,     0.002177777,
@@ -1,6 +1,8 @@
 #ifndef BLACKBODY_CIE_XYZ_H_
 #define BLACKBODY_CIE_XYZ_H_
 
+#include "export.h"
+#include "strided.h"
 #include "units.h"
 
 #ifdef __cplusplus
@@ -14,10 +16,14 @@ extern "C" {
 static const Nanometer CIE_XYZ_LAMBDA_START = { 380 };
 static const Nanometer CIE_XYZ_LAMBDA_END = { 830 };
 static const double CIE_Y_INTEGRAL = 106.856895;
-extern const double CIE_X[];
-extern const double CIE_Y[];
-extern const double CIE_Z[];
 #define CIE_XYZ_SAMPLES 471llu
+// The tables are cache-line aligned and zero-padded by one sample, which makes them a whole number of cache
+// lines (59) and lets the vectorized reductions cover the last samples with full, aligned loads
+#define CIE_XYZ_ALIGNMENT 64
+#define CIE_XYZ_PADDED_SAMPLES 472llu
+extern BLACKBODY_API const double CIE_X[CIE_XYZ_PADDED_SAMPLES];
+extern BLACKBODY_API const double CIE_Y[CIE_XYZ_PADDED_SAMPLES];
+extern BLACKBODY_API const double CIE_Z[CIE_XYZ_PADDED_SAMPLES];
 
 // Represents 
 typedef struct CieXyz {
@@ -33,15 +39,91 @@ typedef struct ColorRgb {
 	double b;
 } ColorRgb;
 
+// Destination of XYZ values in caller-owned memory, one view per channel
+typedef struct CieXyzView {
+	StridedView x;
+	StridedView y;
+	StridedView z;
+} CieXyzView;
+
+// Destination of RGB values in caller-owned memory, one view per channel
+typedef struct ColorRgbView {
+	StridedView r;
+	StridedView g;
+	StridedView b;
+} ColorRgbView;
+
+// Wavelength resolutions the response tables are available in; the value is the
+// number of 1nm samples that make up one step
+typedef enum CieResolution {
+	CIE_RESOLUTION_1NM = 1,
+	CIE_RESOLUTION_5NM = 5,
+	CIE_RESOLUTION_10NM = 10
+} CieResolution;
+
+// Index range [begin, end) outside of which a channel's response is zero
+typedef struct CieExtent {
+	size_t begin;
+	size_t end;
+} CieExtent;
+
+/**
+ * Response tables resampled to a coarser wavelength grid over the CIE range.
+ * The coarse weights are derived from the 1nm data with a tent filter, i.e. they integrate
+ * the linear interpolation of the coarse spectrum samples against the 1nm response.
+ */
+typedef struct CieTable {
+	CieResolution resolution;
+	size_t samples;		// Number of spectrum samples between CIE_XYZ_LAMBDA_START and CIE_XYZ_LAMBDA_END
+	double x[CIE_XYZ_SAMPLES];
+	double y[CIE_XYZ_SAMPLES];
+	double z[CIE_XYZ_SAMPLES];
+	CieExtent xExtent;
+	CieExtent yExtent;
+	CieExtent zExtent;
+} CieTable;
+
 // Takes a color in XYZ space (D65) and converts it to linear RGB (ITU-R BT.709 without gamma correction).
-ColorRgb cie_xyz_to_rgb(const CieXyz);
+BLACKBODY_API ColorRgb cie_xyz_to_rgb(const CieXyz);
 
 /**
  * Converts a spectrum into XYZ color space.
  * This function assumes that the spectral radiances are samples from 380 to 830nm in 1nm increments
  * (see CIE_XYZ_LAMBDA_START and CIE_XYZ_LAMBDA_END).
  */
-CieXyz cie_spectrum_to_xyz(SpectralRadiance spectralRadiance[STATIC_SIZE(CIE_XYZ_SAMPLES)]);
+BLACKBODY_API CieXyz cie_spectrum_to_xyz(const SpectralRadiance spectralRadiance[STATIC_SIZE(CIE_XYZ_SAMPLES)]);
+
+/**
+ * Same as cie_spectrum_to_xyz, but with compensated (Neumaier) summation.
+ * The result is accurate to about one rounding error regardless of the spectrum's dynamic range.
+ */
+BLACKBODY_API CieXyz cie_spectrum_to_xyz_compensated(const SpectralRadiance spectralRadiance[STATIC_SIZE(CIE_XYZ_SAMPLES)]);
+
+// Fills the table with the response data for the given resolution
+BLACKBODY_API void cie_table_init(CieTable* table, const CieResolution resolution);
+
+/**
+ * Converts a spectrum into XYZ color space using the given table.
+ * The spectrum has to consist of table->samples samples evenly spaced from 380 to 830nm
+ * (e.g. from black_body_compute_samples); only the nonzero extent of each channel is visited.
+ */
+BLACKBODY_API CieXyz cie_spectrum_to_xyz_table(const CieTable* table, const SpectralRadiance spectralRadiance[]);
+
+/**
+ * Converts a batch of spectra into XYZ color space.
+ * The spectra are stored one after another, each with CIE_XYZ_SAMPLES samples laid out as for
+ * cie_spectrum_to_xyz. If emissivity is not NULL, it holds the spectral emissivity of every spectrum,
+ * with the same layout as the spectra (CIE_XYZ_SAMPLES values each), and the samples are multiplied
+ * by it as they are summed up. Pairs of spectra share each load of the response tables, and the zero
+ * tail of Z is skipped; for finite spectra the results are identical to cie_spectrum_to_xyz on the
+ * spectra multiplied by their emissivity.
+ */
+BLACKBODY_API void cie_spectra_to_xyz(const size_t count, const SpectralRadiance spectra[],
+                                      const double emissivity[], CieXyz xyz[STATIC_SIZE(count)]);
+
+// Same as cie_spectra_to_xyz, but writes the i-th color's channels to the given views
+BLACKBODY_API void cie_spectra_to_xyz_strided(const size_t count, const SpectralRadiance spectra[],
+                                              const double emissivity[], const CieXyzView xyz);
 
 #ifdef __cplusplus
 } // extern "C"
@@ -0,0 +1,29 @@
+#ifndef BLACKBODY_EXPORT_H_
+#define BLACKBODY_EXPORT_H_
+
+// Version of the library's C ABI. The major version changes whenever exported
+// functions or the layout of public structs change incompatibly. CMake derives the shared
+// library's version from these and checks that src/blackbody.map has a matching version node.
+#define BLACKBODY_VERSION_MAJOR 1
+#define BLACKBODY_VERSION_MINOR 0
+
+// BLACKBODY_API marks the functions and data exported from the shared library.
+// BLACKBODY_SHARED is defined for users of the shared library, BLACKBODY_BUILDING
+// while compiling it; for the static library the macro expands to nothing.
+#if defined(BLACKBODY_SHARED)
+#if defined(_WIN32)
+#if defined(BLACKBODY_BUILDING)
+#define BLACKBODY_API __declspec(dllexport)
+#else
+#define BLACKBODY_API __declspec(dllimport)
+#endif // BLACKBODY_BUILDING
+#elif defined(__GNUC__) || defined(__clang__)
+#define BLACKBODY_API __attribute__((visibility("default")))
+#else
+#define BLACKBODY_API
+#endif // _WIN32
+#else
+#define BLACKBODY_API
+#endif // BLACKBODY_SHARED
+
+#endif // BLACKBODY_EXPORT_H_
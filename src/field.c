@@ -0,0 +1,92 @@
+#include "field.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool black_body_field_init(BlackBodyField* field, const size_t cells, const Kelvin tolerance,
+						   const BlackBodyFieldMode mode) {
+	field->cells = cells;
+	field->tolerance = tolerance;
+	field->mode = mode;
+	field->initialized = false;
+	field->reference = (Kelvin*)malloc(sizeof(Kelvin) * (cells > 0u ? cells : 1u));
+	field->colors = (BlackBodyColor*)malloc(sizeof(BlackBodyColor) * (cells > 0u ? cells : 1u));
+	if(field->reference == NULL || field->colors == NULL) {
+		black_body_field_destroy(field);
+		return false;
+	}
+	return true;
+}
+
+void black_body_field_destroy(BlackBodyField* field) {
+	free(field->reference);
+	free(field->colors);
+	field->reference = NULL;
+	field->colors = NULL;
+	field->cells = 0u;
+	field->initialized = false;
+}
+
+void black_body_field_reset(BlackBodyField* field) {
+	field->initialized = false;
+}
+
+// Computes the color for the given temperature, along with its derivative if the mode needs it
+static BlackBodyColor compute_color(const Kelvin T, const BlackBodyFieldMode mode) {
+	BlackBodyColor color;
+	memset(&color, 0, sizeof(color));
+	// Invalid temperatures don't radiate
+	if(!(T.value >= 0.0))
+		return color;
+
+	if(mode == BLACK_BODY_FIELD_LINEARIZE)
+		return black_body_compute_color_with_derivative(T);
+
+	SpectralRadiance spectralRadiance[CIE_XYZ_SAMPLES];
+	black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, T, spectralRadiance);
+	color.xyz = cie_spectrum_to_xyz(spectralRadiance);
+	color.rgb = cie_xyz_to_rgb(color.xyz);
+	return color;
+}
+
+size_t black_body_field_update(BlackBodyField* field, const Kelvin temperatures[STATIC_SIZE(field->cells)],
+							   const CieXyzView xyz, const ColorRgbView rgb) {
+	size_t recomputed = 0u;
+	for(size_t i = 0u; i < field->cells; ++i) {
+		const Kelvin T = temperatures[i];
+		double delta = 0.0;
+		bool recompute = !field->initialized;
+		if(!recompute) {
+			// The negated comparison also catches NaN on either side
+			delta = T.value - field->reference[i].value;
+			recompute = !(fabs(delta) <= field->tolerance.value);
+		}
+		if(recompute) {
+			field->reference[i] = T;
+			field->colors[i] = compute_color(T, field->mode);
+			delta = 0.0;
+			++recomputed;
+		}
+
+		const BlackBodyColor* color = &field->colors[i];
+		if(field->mode == BLACK_BODY_FIELD_LINEARIZE && delta != 0.0) {
+			// First-order update from the reference; both conversions are linear in the spectrum,
+			// so the stored derivatives are exact at the reference
+			strided_view_store(xyz.x, i, color->xyz.x + color->dXyz.x * delta);
+			strided_view_store(xyz.y, i, color->xyz.y + color->dXyz.y * delta);
+			strided_view_store(xyz.z, i, color->xyz.z + color->dXyz.z * delta);
+			strided_view_store(rgb.r, i, color->rgb.r + color->dRgb.r * delta);
+			strided_view_store(rgb.g, i, color->rgb.g + color->dRgb.g * delta);
+			strided_view_store(rgb.b, i, color->rgb.b + color->dRgb.b * delta);
+		} else {
+			strided_view_store(xyz.x, i, color->xyz.x);
+			strided_view_store(xyz.y, i, color->xyz.y);
+			strided_view_store(xyz.z, i, color->xyz.z);
+			strided_view_store(rgb.r, i, color->rgb.r);
+			strided_view_store(rgb.g, i, color->rgb.g);
+			strided_view_store(rgb.b, i, color->rgb.b);
+		}
+	}
+	field->initialized = true;
+	return recomputed;
+}
@@ -0,0 +1,65 @@
+#ifndef BLACKBODY_FIELD_H_
+#define BLACKBODY_FIELD_H_
+
+#include "blackbody.h"
+#include "cie_xyz.h"
+#include "export.h"
+#include "units.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "util.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// How cells whose temperature stayed within the tolerance of their reference are converted
+typedef enum BlackBodyFieldMode {
+	BLACK_BODY_FIELD_HOLD,		// Keep the color computed for the reference temperature
+	BLACK_BODY_FIELD_LINEARIZE	// Extrapolate from the reference with the temperature derivative of the color
+} BlackBodyFieldMode;
+
+/**
+ * Converts a temperature field to colors frame by frame, recomputing only the cells whose temperature
+ * moved further than the tolerance away from the temperature their color was last computed for
+ * (their reference). All other cells reuse the stored color, so the cost of a frame scales with the
+ * number of changed cells rather than the size of the field.
+ * In BLACK_BODY_FIELD_LINEARIZE mode the error of a reused color grows quadratically with the distance
+ * to the reference instead of linearly, which allows for much larger tolerances at the same accuracy.
+ */
+typedef struct BlackBodyField {
+	size_t cells;
+	Kelvin tolerance;
+	BlackBodyFieldMode mode;
+	bool initialized;			// Whether a frame has been converted since init/reset
+	Kelvin* reference;
+	BlackBodyColor* colors;		// Colors at the reference temperatures; derivatives only in BLACK_BODY_FIELD_LINEARIZE mode
+} BlackBodyField;
+
+/**
+ * Allocates the per-cell state for a field of the given size.
+ * Returns false if out of memory.
+ */
+BLACKBODY_API bool black_body_field_init(BlackBodyField* field, const size_t cells, const Kelvin tolerance,
+										 const BlackBodyFieldMode mode);
+
+// Releases the per-cell state
+BLACKBODY_API void black_body_field_destroy(BlackBodyField* field);
+
+// Forces every cell to be recomputed with the next frame (e.g. after changing tolerance or mode)
+BLACKBODY_API void black_body_field_reset(BlackBodyField* field);
+
+/**
+ * Converts the next frame of temperatures and writes the i-th cell's color to the given views;
+ * channels with a NULL base are skipped. Invalid (negative or NaN) temperatures yield black.
+ * Returns the number of cells that had to be recomputed; the first frame after init/reset recomputes all of them.
+ */
+BLACKBODY_API size_t black_body_field_update(BlackBodyField* field, const Kelvin temperatures[STATIC_SIZE(field->cells)],
+											 const CieXyzView xyz, const ColorRgbView rgb);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // BLACKBODY_FIELD_H_
@@ -4,8 +4,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif // _WIN32
 #include "blackbody.h"
 #include "cie_xyz.h"
+#include "output.h"
 #include "units.h"
 #include "util.h"
 
@@ -16,6 +21,7 @@ typedef struct CmdParameters {
 	size_t samples;
 	bool printSamples;
 	bool printNormalizedSamlples;
+	OutputFormat format;
 	const char* error;
 } CmdParameters;
 
@@ -26,6 +32,7 @@ static CmdParameters parse_cmd_options(int argc, char* argv[STATIC_SIZE(argc + 1
 		.start = CIE_XYZ_LAMBDA_START,
 		.end = CIE_XYZ_LAMBDA_END,
 		.samples = CIE_XYZ_SAMPLES,
+		.format = OUTPUT_FORMAT_TEXT,
 		.error = NULL
 	};
 	
@@ -77,8 +84,9 @@ static CmdParameters parse_cmd_options(int argc, char* argv[STATIC_SIZE(argc + 1
 				params.error = "END must not be < START";
 				return params;
 			}
-			if(params.samples <= 0) {
-				params.error = "SAMPLES must not be <= 0";
+			// The spacing of the samples is (END - START) / (SAMPLES - 1)
+			if(params.samples < 2u) {
+				params.error = "SAMPLES must not be < 2";
 				return params;
 			}
 
@@ -86,10 +94,28 @@ static CmdParameters parse_cmd_options(int argc, char* argv[STATIC_SIZE(argc + 1
 			i += 3;
 		} else if(strncmp("--print-samples", argv[i], 15) == 0) {
 			params.printSamples = true;
-		} else if(strncmp("--print-normalized-samples", argv[i], 26)) {
+		} else if(strncmp("--print-normalized-samples", argv[i], 26) == 0) {
 			params.printNormalizedSamlples = true;
+		} else if(strncmp("--format", argv[i], 8) == 0) {
+			if(argc < i + 2) {
+				params.error = "missing option parameter for --format";
+				return params;
+			}
+			const char* format = argv[++i];
+			if(strcmp(format, "text") == 0) {
+				params.format = OUTPUT_FORMAT_TEXT;
+			} else if(strcmp(format, "csv") == 0) {
+				params.format = OUTPUT_FORMAT_CSV;
+			} else if(strcmp(format, "ndjson") == 0) {
+				params.format = OUTPUT_FORMAT_NDJSON;
+			} else if(strcmp(format, "binary") == 0) {
+				params.format = OUTPUT_FORMAT_BINARY;
+			} else {
+				params.error = "FORMAT must be one of text, csv, ndjson, binary";
+				return params;
+			}
 		} else {
-			printf("Warning: unrecognized option '%s'\n", argv[i]);
+			fprintf(stderr, "Warning: unrecognized option '%s'\n", argv[i]);
 		}
 	}
 
@@ -102,7 +128,8 @@ int main(int argc, char* argv[STATIC_SIZE(argc + 1)]) {
 			fprintf(stderr, "Usage: %s [temperature in Kelvin] [Options]\n"
 							"Options: --range START END N: replaces the standard range (380 to 830nm) with custom range and sample count\n"
 							"         --print-samples: outputs the black-body samples to stdout\n"
-							"         --print-normalized-samples: outputs the normalized black-body samples to stdout"
+							"         --print-normalized-samples: outputs the normalized black-body samples to stdout\n"
+							"         --format FORMAT: selects the output encoding (text, csv, ndjson, binary; default text)\n"
 							"The program computes the XYZ/RGB representation of a black-body spectrum defined by the given temperature (in Kelvin).",
 					argv[0]);
 		else
@@ -118,13 +145,30 @@ int main(int argc, char* argv[STATIC_SIZE(argc + 1)]) {
 	}
 
 	SpectralRadiance* spectralRadiance = (SpectralRadiance*)malloc(sizeof(SpectralRadiance) * params.samples);
-
+	OutputBuffer output;
+	if(spectralRadiance == NULL || !output_init(&output, stdout, OUTPUT_DEFAULT_CAPACITY, params.format)) {
+		fprintf(stderr, "Error: out of memory!\n");
+		return EXIT_FAILURE;
+	}
+#ifdef _WIN32
+	if(params.format == OUTPUT_FORMAT_BINARY)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif // _WIN32
 
 	// TODO: other sampling!
 	black_body_compute_samples(params.start, params.end, params.samples, params.temperature, spectralRadiance);
 	
-	// Weight the samples with the XYZ response
-	const CieXyz xyz = cie_spectrum_to_xyz(spectralRadiance);
+	// Weight the samples with the XYZ response; the response data only covers the standard range,
+	// so a custom range needs its own set of samples for the color
+	SpectralRadiance cieSpectralRadiance[CIE_XYZ_SAMPLES];
+	SpectralRadiance* colorSamples = spectralRadiance;
+	if(params.start.value != CIE_XYZ_LAMBDA_START.value || params.end.value != CIE_XYZ_LAMBDA_END.value
+	   || params.samples != CIE_XYZ_SAMPLES) {
+		black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES,
+								   params.temperature, cieSpectralRadiance);
+		colorSamples = cieSpectralRadiance;
+	}
+	const CieXyz xyz = cie_spectrum_to_xyz(colorSamples);
 	const ColorRgb rgb = cie_xyz_to_rgb(xyz);
 	
 	const double normalizer = fmax(fmax(rgb.r, rgb.g), rgb.b);
@@ -134,25 +178,31 @@ int main(int argc, char* argv[STATIC_SIZE(argc + 1)]) {
 		.b = rgb.b / normalizer
 	};
 	
+	// Wavelength of the i-th sample, computed with the same expression as in black_body_compute_samples
+	const double range = params.end.value - params.start.value;
+	const double last = (double)(params.samples - 1u);
 	if(params.printSamples) {
-		for(size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i)
-			printf("%fnm: %f\n", CIE_XYZ_LAMBDA_START.value + (double)i, spectralRadiance[i].value);
+		for(size_t i = 0u; i < params.samples; ++i) {
+			const Nanometer lambda = { params.start.value + range * (double)i / last };
+			output_write_sample(&output, lambda, spectralRadiance[i]);
+		}
 	}
 	if(params.printNormalizedSamlples) {
 		// Compute normalization factor
 		double max = 0.0;
-		for(size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i)
+		for(size_t i = 0u; i < params.samples; ++i)
 			max = fmax(max, spectralRadiance[i].value);
 
-		for(size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i)
-			printf("%fnm: %f\n", CIE_XYZ_LAMBDA_START.value + (double)i, spectralRadiance[i].value / max);
+		for(size_t i = 0u; i < params.samples; ++i) {
+			const Nanometer lambda = { params.start.value + range * (double)i / last };
+			const SpectralRadiance normalized = { spectralRadiance[i].value / max };
+			output_write_normalized_sample(&output, lambda, normalized);
+		}
 	}
 	
-	printf("Black-body color for %fK:\nXYZ:\t\t\t[ %f, %f, %f ]\nRGB:\t\t\t[ %f, %f, %f ]\nRGB(normalized):\t[ %f, %f, %f ]\n",
-		   params.temperature.value,
-		   xyz.x, xyz.y, xyz.z,
-		   rgb.r, rgb.g, rgb.b,
-		   normRgb.r, normRgb.g, normRgb.b);
+	output_write_color(&output, params.temperature, xyz, rgb, normRgb);
+	output_destroy(&output);
+	free(spectralRadiance);
 	
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include "output.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest record any encoder appends at once
+#define OUTPUT_MAX_RECORD_CHARS (16u * OUTPUT_DOUBLE_MAX_CHARS + 128u)
+
+bool output_init(OutputBuffer* output, FILE* stream, size_t capacity, const OutputFormat format) {
+	if(capacity < OUTPUT_MAX_RECORD_CHARS)
+		capacity = capacity == 0u ? OUTPUT_DEFAULT_CAPACITY : OUTPUT_MAX_RECORD_CHARS;
+
+	output->stream = stream;
+	output->data = (char*)malloc(capacity);
+	output->size = 0u;
+	output->capacity = output->data != NULL ? capacity : 0u;
+	output->format = format;
+	output->lastRecord = OUTPUT_RECORD_NONE;
+	return output->data != NULL;
+}
+
+void output_destroy(OutputBuffer* output) {
+	output_flush(output);
+	free(output->data);
+	output->data = NULL;
+	output->capacity = 0u;
+}
+
+void output_flush(OutputBuffer* output) {
+	if(output->size > 0u)
+		fwrite(output->data, 1u, output->size, output->stream);
+	output->size = 0u;
+}
+
+// Makes sure that a full record fits into the buffer and returns the write position
+static char* output_reserve(OutputBuffer* output) {
+	if(output->capacity - output->size < OUTPUT_MAX_RECORD_CHARS)
+		output_flush(output);
+	return output->data + output->size;
+}
+
+static char* write_string(char* dst, const char* str) {
+	const size_t length = strlen(str);
+	memcpy(dst, str, length);
+	return dst + length;
+}
+
+static char* write_double(char* dst, const double value) {
+	return dst + output_format_double(value, dst);
+}
+
+// JSON has no representation for non-finite numbers
+static char* write_json_double(char* dst, const double value) {
+	return isfinite(value) ? write_double(dst, value) : write_string(dst, "null");
+}
+
+static char* write_raw_double(char* dst, const double value) {
+	memcpy(dst, &value, sizeof(value));
+	return dst + sizeof(value);
+}
+
+// Writes the decimal number d_1.d_2...d_n * 10^exponent given by the digits of mantissa, using fixed
+// notation for moderate exponents and scientific notation (as printf's %g does) otherwise
+static char* write_decimal(char* dst, uint64_t mantissa, const int exponent) {
+	char digits[24u];
+	int count = 0;
+	do {
+		digits[count++] = (char)('0' + mantissa % 10u);
+		mantissa /= 10u;
+	} while(mantissa > 0u);
+	// The digits are reversed; trailing zeros carry no information
+	int first = 0;
+	while(first < count - 1 && digits[first] == '0')
+		++first;
+
+	if(exponent >= 0 && exponent < 17) {
+		for(int i = count - 1; i >= first || count - 1 - i <= exponent; --i) {
+			if(count - 1 - i == exponent + 1)
+				*dst++ = '.';
+			*dst++ = i >= 0 ? digits[i] : '0';
+		}
+	} else if(exponent < 0 && exponent >= -5) {
+		*dst++ = '0';
+		*dst++ = '.';
+		for(int i = -1; i > exponent; --i)
+			*dst++ = '0';
+		for(int i = count - 1; i >= first; --i)
+			*dst++ = digits[i];
+	} else {
+		*dst++ = digits[count - 1];
+		if(count - 1 > first)
+			*dst++ = '.';
+		for(int i = count - 2; i >= first; --i)
+			*dst++ = digits[i];
+		dst += sprintf(dst, "e%c%02d", exponent < 0 ? '-' : '+', abs(exponent));
+	}
+	return dst;
+}
+
+// Splits a into two halves with at most 26 significant bits each (Veltkamp)
+static void split_double(const double a, double* high, double* low) {
+	const double c = 134217729.0 * a;
+	*high = c - (c - a);
+	*low = a - *high;
+}
+
+/**
+ * Computes the decimal mantissa round(magnitude * 10^shift) for mantissas that don't fit into a double
+ * and checks whether it parses back to magnitude. The product is evaluated exactly as high + low
+ * (Dekker), so the distance of the decimal to magnitude is known precisely enough to compare it
+ * against half the gap to the neighbouring doubles.
+ */
+static bool exact_mantissa(const double magnitude, const double power, const bool alwaysValid, uint64_t* mantissa) {
+	double aHigh, aLow, bHigh, bLow;
+	split_double(magnitude, &aHigh, &aLow);
+	split_double(power, &bHigh, &bLow);
+	const double high = magnitude * power;
+	const double low = ((aHigh * bHigh - high) + aHigh * bLow + aLow * bHigh) + aLow * bLow;
+
+	const double integer = floor(high);
+	const double fraction = high - integer;
+	// Can be -1 if low is negative enough, so the sum is formed in signed arithmetic
+	const double roundUp = floor(fraction + low + 0.5);
+	*mantissa = (uint64_t)((int64_t)integer + (int64_t)roundUp);
+	if(alwaysValid)
+		return true;
+
+	// Decimal minus exact product, both scaled by 10^shift; every step up to the last one is exact
+	const double distance = (roundUp - fraction) - low;
+	const double gap = fmin(nextafter(magnitude, INFINITY) - magnitude, magnitude - nextafter(magnitude, 0.0));
+	// Leave some slack for the rounding of the last subtraction
+	return fabs(distance) < 0.5 * gap * power - 1.0e-6;
+}
+
+size_t output_format_double(const double value, char buffer[STATIC_SIZE(OUTPUT_DOUBLE_MAX_CHARS)]) {
+	static const double POWERS_OF_TEN[] = {
+		1.0e0, 1.0e1, 1.0e2, 1.0e3, 1.0e4, 1.0e5, 1.0e6, 1.0e7, 1.0e8, 1.0e9, 1.0e10, 1.0e11,
+		1.0e12, 1.0e13, 1.0e14, 1.0e15, 1.0e16, 1.0e17, 1.0e18, 1.0e19, 1.0e20, 1.0e21, 1.0e22
+	};
+	static const int MAX_EXACT_POWER = 22;
+	static const double MAX_EXACT_MANTISSA = 9007199254740992.0;
+
+	char* dst = buffer;
+	if(isnan(value))
+		return (size_t)(write_string(dst, "nan") - buffer);
+	if(signbit(value))
+		*dst++ = '-';
+	const double magnitude = fabs(value);
+	if(isinf(magnitude))
+		return (size_t)(write_string(dst, "inf") - buffer);
+	if(magnitude == 0.0) {
+		*dst++ = '0';
+		return (size_t)(dst - buffer);
+	}
+
+	// Fast path: find the fewest significant digits p for which m = round(|v| * 10^(p-1-e)) gives back |v|.
+	// As long as m stays below 2^53 and the power of ten is exact, scaling m back is correctly rounded,
+	// so the decimal m * 10^-(p-1-e) is guaranteed to parse back to the same value.
+	// Longer mantissas are checked with exact products instead; 17 digits always round-trip.
+	const int exponent = (int)floor(log10(magnitude));
+	for(int precision = 1; precision <= 17; ++precision) {
+		const int shift = precision - 1 - exponent;
+		if(shift > MAX_EXACT_POWER || shift < -MAX_EXACT_POWER)
+			break;
+		const double scaled = shift >= 0 ? magnitude * POWERS_OF_TEN[shift] : magnitude / POWERS_OF_TEN[-shift];
+		const double mantissa = nearbyint(scaled);
+		bool valid = false;
+		uint64_t digits = 0u;
+		if(mantissa < MAX_EXACT_MANTISSA) {
+			// scaled is rounded already, so the nearest decimal may also be one of the neighbours of mantissa
+			const double candidates[] = { mantissa, mantissa - 1.0, mantissa + 1.0 };
+			for(size_t i = 0u; i < sizeof(candidates) / sizeof(candidates[0]) && !valid; ++i) {
+				const double candidate = candidates[i];
+				if(!(candidate > 0.0 && candidate < MAX_EXACT_MANTISSA))
+					continue;
+				const double roundTrip = shift >= 0 ? candidate / POWERS_OF_TEN[shift] : candidate * POWERS_OF_TEN[-shift];
+				valid = roundTrip == magnitude;
+				digits = (uint64_t)candidate;
+			}
+		} else if(shift >= 0) {
+			valid = exact_mantissa(magnitude, POWERS_OF_TEN[shift], precision == 17, &digits);
+		} else {
+			break;
+		}
+
+		if(valid) {
+			// The mantissa may have one digit more or less than expected (rounding up, inexact log10)
+			int count = 1;
+			for(uint64_t bound = 10u; digits >= bound && count < 19; bound *= 10u)
+				++count;
+			return (size_t)(write_decimal(dst, digits, count - 1 - shift) - buffer);
+		}
+	}
+
+	// Slow path for the extremes of the exponent range: increase the precision until the value round-trips
+	for(int precision = 1; precision <= 17; ++precision) {
+		const int length = snprintf(dst, OUTPUT_DOUBLE_MAX_CHARS - 1u, "%.*g", precision, magnitude);
+		if(precision == 17 || strtod(dst, NULL) == magnitude)
+			return (size_t)(dst - buffer) + (size_t)length;
+	}
+	return 0u;
+}
+
+// Appends a sample record; the two sample record types only differ in their field names and tags
+static void write_sample_record(OutputBuffer* output, const OutputRecord record,
+								const Nanometer wavelength, const SpectralRadiance radiance) {
+	const bool normalized = record == OUTPUT_RECORD_NORMALIZED_SAMPLE;
+	char* dst = output_reserve(output);
+	switch(output->format) {
+		case OUTPUT_FORMAT_TEXT:
+			dst = write_double(dst, wavelength.value);
+			dst = write_string(dst, "nm: ");
+			dst = write_double(dst, radiance.value);
+			*dst++ = '\n';
+			break;
+		case OUTPUT_FORMAT_CSV:
+			if(output->lastRecord != record)
+				dst = write_string(dst, normalized ? "wavelength,normalized_radiance\n" : "wavelength,radiance\n");
+			dst = write_double(dst, wavelength.value);
+			*dst++ = ',';
+			dst = write_double(dst, radiance.value);
+			*dst++ = '\n';
+			break;
+		case OUTPUT_FORMAT_NDJSON:
+			dst = write_string(dst, "{\"wavelength\":");
+			dst = write_json_double(dst, wavelength.value);
+			dst = write_string(dst, normalized ? ",\"normalizedRadiance\":" : ",\"radiance\":");
+			dst = write_json_double(dst, radiance.value);
+			dst = write_string(dst, "}\n");
+			break;
+		case OUTPUT_FORMAT_BINARY:
+			dst = write_raw_double(dst, (double)record);
+			dst = write_raw_double(dst, wavelength.value);
+			dst = write_raw_double(dst, radiance.value);
+			break;
+	}
+	output->size = (size_t)(dst - output->data);
+	output->lastRecord = record;
+}
+
+void output_write_sample(OutputBuffer* output, const Nanometer wavelength, const SpectralRadiance radiance) {
+	write_sample_record(output, OUTPUT_RECORD_SAMPLE, wavelength, radiance);
+}
+
+void output_write_normalized_sample(OutputBuffer* output, const Nanometer wavelength, const SpectralRadiance radiance) {
+	write_sample_record(output, OUTPUT_RECORD_NORMALIZED_SAMPLE, wavelength, radiance);
+}
+
+// Writes the given values separated by sep
+static char* write_list(char* dst, const double* values, const size_t count, const char* sep, const bool json) {
+	for(size_t i = 0u; i < count; ++i) {
+		if(i > 0u)
+			dst = write_string(dst, sep);
+		dst = json ? write_json_double(dst, values[i]) : write_double(dst, values[i]);
+	}
+	return dst;
+}
+
+void output_write_color(OutputBuffer* output, const Kelvin temperature, const CieXyz xyz,
+						const ColorRgb rgb, const ColorRgb normalizedRgb) {
+	const double xyzValues[3u] = { xyz.x, xyz.y, xyz.z };
+	const double rgbValues[3u] = { rgb.r, rgb.g, rgb.b };
+	const double normValues[3u] = { normalizedRgb.r, normalizedRgb.g, normalizedRgb.b };
+
+	char* dst = output_reserve(output);
+	switch(output->format) {
+		case OUTPUT_FORMAT_TEXT:
+			dst = write_string(dst, "Black-body color for ");
+			dst = write_double(dst, temperature.value);
+			dst = write_string(dst, "K:\nXYZ:\t\t\t[ ");
+			dst = write_list(dst, xyzValues, 3u, ", ", false);
+			dst = write_string(dst, " ]\nRGB:\t\t\t[ ");
+			dst = write_list(dst, rgbValues, 3u, ", ", false);
+			dst = write_string(dst, " ]\nRGB(normalized):\t[ ");
+			dst = write_list(dst, normValues, 3u, ", ", false);
+			dst = write_string(dst, " ]\n");
+			break;
+		case OUTPUT_FORMAT_CSV:
+			if(output->lastRecord != OUTPUT_RECORD_COLOR)
+				dst = write_string(dst, "temperature,x,y,z,r,g,b,r_normalized,g_normalized,b_normalized\n");
+			dst = write_double(dst, temperature.value);
+			*dst++ = ',';
+			dst = write_list(dst, xyzValues, 3u, ",", false);
+			*dst++ = ',';
+			dst = write_list(dst, rgbValues, 3u, ",", false);
+			*dst++ = ',';
+			dst = write_list(dst, normValues, 3u, ",", false);
+			*dst++ = '\n';
+			break;
+		case OUTPUT_FORMAT_NDJSON:
+			dst = write_string(dst, "{\"temperature\":");
+			dst = write_json_double(dst, temperature.value);
+			dst = write_string(dst, ",\"xyz\":[");
+			dst = write_list(dst, xyzValues, 3u, ",", true);
+			dst = write_string(dst, "],\"rgb\":[");
+			dst = write_list(dst, rgbValues, 3u, ",", true);
+			dst = write_string(dst, "],\"rgbNormalized\":[");
+			dst = write_list(dst, normValues, 3u, ",", true);
+			dst = write_string(dst, "]}\n");
+			break;
+		case OUTPUT_FORMAT_BINARY:
+			dst = write_raw_double(dst, (double)OUTPUT_RECORD_COLOR);
+			dst = write_raw_double(dst, temperature.value);
+			for(size_t i = 0u; i < 3u; ++i)
+				dst = write_raw_double(dst, xyzValues[i]);
+			for(size_t i = 0u; i < 3u; ++i)
+				dst = write_raw_double(dst, rgbValues[i]);
+			for(size_t i = 0u; i < 3u; ++i)
+				dst = write_raw_double(dst, normValues[i]);
+			break;
+	}
+	output->size = (size_t)(dst - output->data);
+	output->lastRecord = OUTPUT_RECORD_COLOR;
+}
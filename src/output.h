@@ -0,0 +1,80 @@
+#ifndef BLACKBODY_OUTPUT_H_
+#define BLACKBODY_OUTPUT_H_
+
+#include "cie_xyz.h"
+#include "units.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "util.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Buffer size output_format_double needs (it writes fewer characters and no terminator)
+#define OUTPUT_DOUBLE_MAX_CHARS 32u
+// Buffer size used if none is given
+#define OUTPUT_DEFAULT_CAPACITY (1u << 20u)
+
+// Encodings for the printed samples and colors
+typedef enum OutputFormat {
+	OUTPUT_FORMAT_TEXT,		// Human-readable, one line per sample
+	OUTPUT_FORMAT_CSV,		// Comma-separated with a header line per record type
+	OUTPUT_FORMAT_NDJSON,	// One JSON object per line
+	OUTPUT_FORMAT_BINARY	// Raw native-endian doubles, every record led by its OutputRecord tag
+} OutputFormat;
+
+// Record types; they determine the CSV header and NDJSON field names, and tag every binary record
+typedef enum OutputRecord {
+	OUTPUT_RECORD_NONE,
+	OUTPUT_RECORD_SAMPLE,				// Binary: tag, wavelength, radiance
+	OUTPUT_RECORD_NORMALIZED_SAMPLE,	// Binary: tag, wavelength, normalized radiance
+	OUTPUT_RECORD_COLOR					// Binary: tag, temperature, x, y, z, r, g, b, normalized r, g, b
+} OutputRecord;
+
+/**
+ * Accumulates encoded records in a single reusable buffer and hands it to the stream
+ * only when it is full (or when flushed), which avoids per-record stdio overhead.
+ */
+typedef struct OutputBuffer {
+	FILE* stream;
+	char* data;
+	size_t size;
+	size_t capacity;
+	OutputFormat format;
+	OutputRecord lastRecord;	// Type of the previously written record (for CSV headers)
+} OutputBuffer;
+
+// Allocates the buffer; a capacity of 0 selects OUTPUT_DEFAULT_CAPACITY. Returns false if out of memory
+bool output_init(OutputBuffer* output, FILE* stream, size_t capacity, const OutputFormat format);
+
+// Flushes the remaining content and releases the buffer
+void output_destroy(OutputBuffer* output);
+
+// Writes the buffered content to the stream
+void output_flush(OutputBuffer* output);
+
+/**
+ * Writes the shortest decimal representation of value that reads back as the same double
+ * (not null-terminated) and returns its length. Values that are short decimal fractions are
+ * formatted in fixed notation without going through printf.
+ */
+size_t output_format_double(const double value, char buffer[STATIC_SIZE(OUTPUT_DOUBLE_MAX_CHARS)]);
+
+// Appends a single spectral sample in the buffer's format
+void output_write_sample(OutputBuffer* output, const Nanometer wavelength, const SpectralRadiance radiance);
+
+// Appends a sample of a spectrum normalized to its maximum; a record type of its own keeps it apart from raw samples
+void output_write_normalized_sample(OutputBuffer* output, const Nanometer wavelength, const SpectralRadiance radiance);
+
+// Appends the color summary for a temperature in the buffer's format
+void output_write_color(OutputBuffer* output, const Kelvin temperature, const CieXyz xyz,
+						const ColorRgb rgb, const ColorRgb normalizedRgb);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // BLACKBODY_OUTPUT_H_
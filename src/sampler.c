@@ -0,0 +1,184 @@
+#include "sampler.h"
+#include "blackbody.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Width of a single bin [nm]
+static double bin_width(void) {
+	return (CIE_XYZ_LAMBDA_END.value - CIE_XYZ_LAMBDA_START.value) / (double)BLACK_BODY_SAMPLER_BINS;
+}
+
+// Finds the bin containing the wavelength, or BLACK_BODY_SAMPLER_BINS if it lies outside of the CIE range
+static size_t find_bin(const Nanometer wavelength) {
+	const double offset = (wavelength.value - CIE_XYZ_LAMBDA_START.value) / bin_width();
+	if(!(offset >= 0.0) || offset > (double)BLACK_BODY_SAMPLER_BINS)
+		return BLACK_BODY_SAMPLER_BINS;
+	const size_t bin = (size_t)offset;
+	return bin < BLACK_BODY_SAMPLER_BINS ? bin : BLACK_BODY_SAMPLER_BINS - 1u;
+}
+
+bool black_body_sampler_init(BlackBodySampler* sampler, const Kelvin T, const BlackBodySamplerWeight weight) {
+	sampler->temperature = T;
+
+	SpectralRadiance spectralRadiance[CIE_XYZ_SAMPLES];
+	black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, T, spectralRadiance);
+	if(weight == BLACK_BODY_SAMPLER_LUMINANCE) {
+		for(size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i)
+			spectralRadiance[i].value *= CIE_Y[i];
+	}
+
+	// Trapezoidal weight of every bin; the common factor of the bin width cancels out
+	double weights[BLACK_BODY_SAMPLER_BINS];
+	double total = 0.0;
+	for(size_t i = 0u; i < BLACK_BODY_SAMPLER_BINS; ++i) {
+		weights[i] = 0.5 * (spectralRadiance[i].value + spectralRadiance[i + 1u].value);
+		total += weights[i];
+	}
+	const bool valid = total > 0.0 && total < INFINITY;
+	if(!valid) {
+		for(size_t i = 0u; i < BLACK_BODY_SAMPLER_BINS; ++i)
+			weights[i] = 1.0;
+		total = (double)BLACK_BODY_SAMPLER_BINS;
+	}
+
+	// Vose's alias method: bins with less than average weight are topped up with
+	// the excess of a bin with more than average weight, which becomes their alias
+	uint32_t small[BLACK_BODY_SAMPLER_BINS];
+	uint32_t large[BLACK_BODY_SAMPLER_BINS];
+	size_t smallCount = 0u;
+	size_t largeCount = 0u;
+	double scaled[BLACK_BODY_SAMPLER_BINS];
+	const double width = bin_width();
+	for(size_t i = 0u; i < BLACK_BODY_SAMPLER_BINS; ++i) {
+		sampler->pdf[i] = weights[i] / (total * width);
+		scaled[i] = weights[i] * (double)BLACK_BODY_SAMPLER_BINS / total;
+		if(scaled[i] < 1.0)
+			small[smallCount++] = (uint32_t)i;
+		else
+			large[largeCount++] = (uint32_t)i;
+	}
+	while(smallCount > 0u && largeCount > 0u) {
+		const uint32_t less = small[--smallCount];
+		const uint32_t more = large[--largeCount];
+		sampler->probability[less] = scaled[less];
+		sampler->alias[less] = more;
+		scaled[more] = (scaled[more] + scaled[less]) - 1.0;
+		if(scaled[more] < 1.0)
+			small[smallCount++] = more;
+		else
+			large[largeCount++] = more;
+	}
+	// Whatever is left over is (up to rounding) exactly average
+	while(largeCount > 0u) {
+		const uint32_t bin = large[--largeCount];
+		sampler->probability[bin] = 1.0;
+		sampler->alias[bin] = bin;
+	}
+	while(smallCount > 0u) {
+		const uint32_t bin = small[--smallCount];
+		sampler->probability[bin] = 1.0;
+		sampler->alias[bin] = bin;
+	}
+
+	return valid;
+}
+
+double black_body_sampler_pdf(const BlackBodySampler* sampler, const Nanometer wavelength) {
+	const size_t bin = find_bin(wavelength);
+	return bin < BLACK_BODY_SAMPLER_BINS ? sampler->pdf[bin] : 0.0;
+}
+
+// Picks a bin: the integer part of u * bins selects a bin, the fractional part decides between it and its alias
+static size_t draw_bin(const BlackBodySampler* sampler, const double u) {
+	const double scaled = u * (double)BLACK_BODY_SAMPLER_BINS;
+	size_t bin = (size_t)scaled;
+	if(bin >= BLACK_BODY_SAMPLER_BINS)
+		bin = BLACK_BODY_SAMPLER_BINS - 1u;
+	return scaled - (double)bin < sampler->probability[bin] ? bin : sampler->alias[bin];
+}
+
+static Nanometer bin_wavelength(const size_t bin, const double u) {
+	const Nanometer wavelength = { CIE_XYZ_LAMBDA_START.value + ((double)bin + u) * bin_width() };
+	return wavelength;
+}
+
+WavelengthSample black_body_sampler_draw(const BlackBodySampler* sampler, const double u1, const double u2) {
+	const size_t bin = draw_bin(sampler, u1);
+	const WavelengthSample sample = { bin_wavelength(bin, u2), sampler->pdf[bin] };
+	return sample;
+}
+
+void black_body_sampler_draw_batch(const BlackBodySampler* sampler, const size_t count,
+								   const double u[STATIC_SIZE(2u * count)], WavelengthSample samples[STATIC_SIZE(count)]) {
+	for(size_t i = 0u; i < count; ++i)
+		samples[i] = black_body_sampler_draw(sampler, u[2u * i], u[2u * i + 1u]);
+}
+
+bool black_body_sampler_set_init(BlackBodySamplerSet* set, const Kelvin minimum, const Kelvin maximum,
+								 const size_t count, const BlackBodySamplerWeight weight) {
+	set->minimum = minimum;
+	set->maximum = maximum;
+	set->count = count < 2u ? 2u : count;
+	set->samplers = (BlackBodySampler*)malloc(sizeof(BlackBodySampler) * set->count);
+	if(set->samplers == NULL) {
+		set->count = 0u;
+		return false;
+	}
+
+	for(size_t i = 0u; i < set->count; ++i) {
+		const Kelvin T = { minimum.value + (maximum.value - minimum.value) * (double)i / (double)(set->count - 1u) };
+		black_body_sampler_init(&set->samplers[i], T, weight);
+	}
+	return true;
+}
+
+void black_body_sampler_set_destroy(BlackBodySamplerSet* set) {
+	free(set->samplers);
+	set->samplers = NULL;
+	set->count = 0u;
+}
+
+// Finds the lower of the two tables around the temperature and the weight of the upper one
+static size_t find_sampler(const BlackBodySamplerSet* set, const Kelvin T, double* fraction) {
+	const double range = set->maximum.value - set->minimum.value;
+	double position = range > 0.0 ? (T.value - set->minimum.value) / range * (double)(set->count - 1u) : 0.0;
+	if(!(position > 0.0))
+		position = 0.0;
+	if(position > (double)(set->count - 1u))
+		position = (double)(set->count - 1u);
+
+	size_t index = (size_t)position;
+	if(index > set->count - 2u)
+		index = set->count - 2u;
+	*fraction = position - (double)index;
+	return index;
+}
+
+double black_body_sampler_set_pdf(const BlackBodySamplerSet* set, const Kelvin T, const Nanometer wavelength) {
+	double fraction;
+	const size_t index = find_sampler(set, T, &fraction);
+	return (1.0 - fraction) * black_body_sampler_pdf(&set->samplers[index], wavelength)
+		+ fraction * black_body_sampler_pdf(&set->samplers[index + 1u], wavelength);
+}
+
+WavelengthSample black_body_sampler_set_draw(const BlackBodySamplerSet* set, const Kelvin T,
+											 const double u1, const double u2, const double u3) {
+	double fraction;
+	const size_t index = find_sampler(set, T, &fraction);
+	const size_t bin = draw_bin(&set->samplers[u3 < fraction ? index + 1u : index], u1);
+
+	// Either table could have produced the wavelength, so report the density of the mixture
+	const WavelengthSample sample = {
+		bin_wavelength(bin, u2),
+		(1.0 - fraction) * set->samplers[index].pdf[bin] + fraction * set->samplers[index + 1u].pdf[bin]
+	};
+	return sample;
+}
+
+void black_body_sampler_set_draw_batch(const BlackBodySamplerSet* set, const size_t count,
+									   const Kelvin temperatures[STATIC_SIZE(count)],
+									   const double u[STATIC_SIZE(3u * count)],
+									   WavelengthSample samples[STATIC_SIZE(count)]) {
+	for(size_t i = 0u; i < count; ++i)
+		samples[i] = black_body_sampler_set_draw(set, temperatures[i], u[3u * i], u[3u * i + 1u], u[3u * i + 2u]);
+}
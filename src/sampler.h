@@ -0,0 +1,100 @@
+#ifndef BLACKBODY_SAMPLER_H_
+#define BLACKBODY_SAMPLER_H_
+
+#include "cie_xyz.h"
+#include "export.h"
+#include "units.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "util.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The sampled distribution is piecewise constant between the samples of the CIE range
+#define BLACK_BODY_SAMPLER_BINS (CIE_XYZ_SAMPLES - 1u)
+
+// Weighting of the black-body spectrum the wavelengths are drawn from
+typedef enum BlackBodySamplerWeight {
+	BLACK_BODY_SAMPLER_RADIANCE,	// Proportional to B(λ, T)
+	BLACK_BODY_SAMPLER_LUMINANCE	// Proportional to B(λ, T) * CIE_Y(λ)
+} BlackBodySamplerWeight;
+
+// A drawn wavelength along with the probability density it was drawn with
+typedef struct WavelengthSample {
+	Nanometer wavelength;
+	double pdf;	// [1/nm]
+} WavelengthSample;
+
+/**
+ * Alias table for drawing wavelengths from the CIE range in proportion to the black-body spectrum
+ * of a single temperature. The spectrum is integrated with the trapezoidal rule between neighbouring
+ * samples, and within such a bin wavelengths are distributed uniformly.
+ */
+typedef struct BlackBodySampler {
+	Kelvin temperature;
+	double probability[BLACK_BODY_SAMPLER_BINS];	// Probability of keeping a bin instead of taking its alias
+	uint32_t alias[BLACK_BODY_SAMPLER_BINS];
+	double pdf[BLACK_BODY_SAMPLER_BINS];			// Density within each bin [1/nm]
+} BlackBodySampler;
+
+/**
+ * Alias tables for evenly spaced temperatures. Drawing for a temperature in between picks one of
+ * the two neighbouring tables at random (in proportion to the distance), and the returned pdf is
+ * that of the resulting mixture, so estimators weighting by it remain unbiased.
+ */
+typedef struct BlackBodySamplerSet {
+	Kelvin minimum;
+	Kelvin maximum;
+	size_t count;
+	BlackBodySampler* samplers;
+} BlackBodySamplerSet;
+
+/**
+ * Builds the alias table for the given temperature.
+ * Returns false if the spectrum vanishes over the CIE range (e.g. for T = 0), in which case
+ * the sampler falls back to a uniform distribution.
+ */
+BLACKBODY_API bool black_body_sampler_init(BlackBodySampler* sampler, const Kelvin T, const BlackBodySamplerWeight weight);
+
+// Evaluates the density the sampler draws the given wavelength with
+BLACKBODY_API double black_body_sampler_pdf(const BlackBodySampler* sampler, const Nanometer wavelength);
+
+// Draws a wavelength in O(1) from two uniform random numbers in [0, 1)
+BLACKBODY_API WavelengthSample black_body_sampler_draw(const BlackBodySampler* sampler, const double u1, const double u2);
+
+// Draws count wavelengths; the random numbers are consumed as pairs (u[2i], u[2i+1])
+BLACKBODY_API void black_body_sampler_draw_batch(const BlackBodySampler* sampler, const size_t count,
+												 const double u[STATIC_SIZE(2u * count)], WavelengthSample samples[STATIC_SIZE(count)]);
+
+/**
+ * Builds count (at least 2) alias tables for temperatures evenly spaced from minimum to maximum.
+ * Returns false if out of memory.
+ */
+BLACKBODY_API bool black_body_sampler_set_init(BlackBodySamplerSet* set, const Kelvin minimum, const Kelvin maximum,
+											   const size_t count, const BlackBodySamplerWeight weight);
+
+// Releases the tables
+BLACKBODY_API void black_body_sampler_set_destroy(BlackBodySamplerSet* set);
+
+// Evaluates the mixture density for the given temperature (clamped to the set's range)
+BLACKBODY_API double black_body_sampler_set_pdf(const BlackBodySamplerSet* set, const Kelvin T, const Nanometer wavelength);
+
+// Draws a wavelength for the given temperature (clamped to the set's range) from three uniform random numbers in [0, 1)
+BLACKBODY_API WavelengthSample black_body_sampler_set_draw(const BlackBodySamplerSet* set, const Kelvin T,
+														   const double u1, const double u2, const double u3);
+
+// Draws one wavelength per temperature; the random numbers are consumed as triples (u[3i], u[3i+1], u[3i+2])
+BLACKBODY_API void black_body_sampler_set_draw_batch(const BlackBodySamplerSet* set, const size_t count,
+													 const Kelvin temperatures[STATIC_SIZE(count)],
+													 const double u[STATIC_SIZE(3u * count)],
+													 WavelengthSample samples[STATIC_SIZE(count)]);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // BLACKBODY_SAMPLER_H_
@@ -0,0 +1,31 @@
+#ifndef BLACKBODY_STRIDED_H_
+#define BLACKBODY_STRIDED_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * Describes an output channel in caller-owned memory: the i-th value is the double
+ * at (char*)base + i * stride. This allows writing results straight into interleaved
+ * vertex buffers, images or struct-of-arrays layouts. A NULL base skips the channel.
+ */
+typedef struct StridedView {
+	void* base;
+	ptrdiff_t stride;	// [bytes], may be negative
+} StridedView;
+
+// Writes value as the index-th element of the view (which need not be aligned)
+static inline void strided_view_store(const StridedView view, const size_t index, const double value) {
+	if(view.base != NULL)
+		memcpy((char*)view.base + (ptrdiff_t)index * view.stride, &value, sizeof(value));
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // BLACKBODY_STRIDED_H_
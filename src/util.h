@@ -16,5 +16,18 @@
 #define STATIC_SIZE(x) 
 #endif // STATIC_SIZE
 
+#ifdef ALIGNED
+#error "Another header defines our ALIGNED macro already"
+#endif // ALIGNED
+
+// This macro aligns a variable definition to the given number of bytes
+#if defined(_MSC_VER)
+#define ALIGNED(x) __declspec(align(x))
+#elif defined(__GNUC__) || defined(__clang__)
+#define ALIGNED(x) __attribute__((aligned(x)))
+#else
+#define ALIGNED(x)
+#endif // _MSC_VER
+
 
 #endif // BLACKBODY_UTIL_H_
\ No newline at end of file
@@ -89,4 +89,173 @@ TEST(black_body_compute_samples, range_test) {
 	EXPECT_NEAR(samples[0u].value, 2902729253.085279, precision);
 	EXPECT_NEAR(samples[1u].value, 30635070484501.422, precision);
 	EXPECT_NEAR(samples[2u].value, 46097184673518.0, precision);
-}
\ No newline at end of file
+}
+
+TEST(black_body_compute_sample_with_derivative, matches_sample) {
+	const Kelvin temp{ 1500.0 };
+	for(double lambda = 300.0; lambda <= 900.0; lambda += 100.0) {
+		SpectralRadiance derivative{ -1.0 };
+		EXPECT_EQ(black_body_compute_sample_with_derivative(Nanometer{ lambda }, temp, &derivative).value,
+				  black_body_compute_sample(Nanometer{ lambda }, temp).value);
+	}
+
+	SpectralRadiance derivative{ -1.0 };
+	EXPECT_EQ(black_body_compute_sample_with_derivative(Nanometer{ 500.0 }, Kelvin{ 0.0 }, &derivative).value, 0.0);
+	EXPECT_EQ(derivative.value, 0.0);
+
+	// The derivative is optional
+	EXPECT_EQ(black_body_compute_sample_with_derivative(Nanometer{ 500.0 }, temp, nullptr).value,
+			  black_body_compute_sample(Nanometer{ 500.0 }, temp).value);
+	EXPECT_EQ(black_body_compute_sample_with_derivative(Nanometer{ -1.0 }, temp, nullptr).value, 0.0);
+}
+
+TEST(black_body_compute_sample_with_derivative, finite_differences) {
+	// Compare against central differences with a relative tolerance
+	const double h = 0.01;
+	for(double T = 1000.0; T <= 10000.0; T += 1500.0) {
+		for(double lambda = 300.0; lambda <= 900.0; lambda += 100.0) {
+			SpectralRadiance derivative;
+			black_body_compute_sample_with_derivative(Nanometer{ lambda }, Kelvin{ T }, &derivative);
+			const double numeric = (black_body_compute_sample(Nanometer{ lambda }, Kelvin{ T + h }).value
+									- black_body_compute_sample(Nanometer{ lambda }, Kelvin{ T - h }).value) / (2.0 * h);
+			EXPECT_NEAR(derivative.value, numeric, 1.0e-6 * std::abs(numeric));
+		}
+	}
+}
+
+TEST(black_body_compute_color_with_derivative, finite_differences) {
+	const double h = 0.01;
+	for(double T = 1000.0; T <= 10000.0; T += 1500.0) {
+		const BlackBodyColor color = black_body_compute_color_with_derivative(Kelvin{ T });
+		const BlackBodyColor lower = black_body_compute_color_with_derivative(Kelvin{ T - h });
+		const BlackBodyColor upper = black_body_compute_color_with_derivative(Kelvin{ T + h });
+
+		// The color itself has to match the regular pipeline
+		SpectralRadiance samples[CIE_XYZ_SAMPLES];
+		black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, Kelvin{ T }, samples);
+		const CieXyz xyz = cie_spectrum_to_xyz(samples);
+		EXPECT_NEAR(color.xyz.x, xyz.x, 1.0e-9 * xyz.x);
+		EXPECT_NEAR(color.xyz.y, xyz.y, 1.0e-9 * xyz.y);
+		EXPECT_NEAR(color.xyz.z, xyz.z, 1.0e-9 * xyz.z);
+
+		const double dx = (upper.xyz.x - lower.xyz.x) / (2.0 * h);
+		const double dy = (upper.xyz.y - lower.xyz.y) / (2.0 * h);
+		const double dz = (upper.xyz.z - lower.xyz.z) / (2.0 * h);
+		EXPECT_NEAR(color.dXyz.x, dx, 1.0e-6 * std::abs(dx));
+		EXPECT_NEAR(color.dXyz.y, dy, 1.0e-6 * std::abs(dy));
+		EXPECT_NEAR(color.dXyz.z, dz, 1.0e-6 * std::abs(dz));
+
+		const double dr = (upper.rgb.r - lower.rgb.r) / (2.0 * h);
+		EXPECT_NEAR(color.dRgb.r, dr, 1.0e-6 * std::abs(dr));
+	}
+}
+
+TEST(black_body_compute_samples_strided, writes_into_interleaved_buffer) {
+	// Write every sample into the second double of a (wavelength, radiance, padding) triple
+	const std::size_t samples = 16u;
+	double vertices[3u * samples];
+	for(auto& value : vertices)
+		value = -1.0;
+	black_body_compute_samples_strided(Nanometer{ 400.0 }, Nanometer{ 700.0 }, samples, Kelvin{ 3000.0 },
+									   StridedView{ &vertices[1u], static_cast<std::ptrdiff_t>(3u * sizeof(double)) });
+
+	SpectralRadiance expected[samples];
+	black_body_compute_samples(Nanometer{ 400.0 }, Nanometer{ 700.0 }, samples, Kelvin{ 3000.0 }, expected);
+	for(std::size_t i = 0u; i < samples; ++i) {
+		EXPECT_EQ(vertices[3u * i], -1.0);
+		EXPECT_EQ(vertices[3u * i + 1u], expected[i].value);
+		EXPECT_EQ(vertices[3u * i + 2u], -1.0);
+	}
+
+	// Negative strides write in reverse order
+	double reversed[samples];
+	black_body_compute_samples_strided(Nanometer{ 400.0 }, Nanometer{ 700.0 }, samples, Kelvin{ 3000.0 },
+									   StridedView{ &reversed[samples - 1u], -static_cast<std::ptrdiff_t>(sizeof(double)) });
+	for(std::size_t i = 0u; i < samples; ++i)
+		EXPECT_EQ(reversed[samples - 1u - i], expected[i].value);
+}
+
+TEST(black_body_compute_colors_strided, matches_pipeline) {
+	// A vertex layout as a renderer might use it, with XYZ left out
+	struct Vertex {
+		float position[3];
+		double rgb[3];
+	};
+	const Kelvin temperatures[] = { Kelvin{ 1500.0 }, Kelvin{ 4000.0 }, Kelvin{ -1.0 }, Kelvin{ 6500.0 } };
+	const std::size_t count = sizeof(temperatures) / sizeof(temperatures[0]);
+	Vertex vertices[count];
+	const auto stride = static_cast<std::ptrdiff_t>(sizeof(Vertex));
+	const CieXyzView noXyz{ StridedView{ nullptr, 0 }, StridedView{ nullptr, 0 }, StridedView{ nullptr, 0 } };
+	const ColorRgbView rgb{ StridedView{ &vertices[0].rgb[0], stride }, StridedView{ &vertices[0].rgb[1], stride },
+							StridedView{ &vertices[0].rgb[2], stride } };
+	black_body_compute_colors_strided(count, temperatures, noXyz, rgb);
+
+	// Struct-of-arrays for XYZ
+	double x[count], y[count], z[count];
+	const auto packed = static_cast<std::ptrdiff_t>(sizeof(double));
+	const CieXyzView xyz{ StridedView{ x, packed }, StridedView{ y, packed }, StridedView{ z, packed } };
+	const ColorRgbView noRgb{ StridedView{ nullptr, 0 }, StridedView{ nullptr, 0 }, StridedView{ nullptr, 0 } };
+	black_body_compute_colors_strided(count, temperatures, xyz, noRgb);
+
+	for(std::size_t i = 0u; i < count; ++i) {
+		CieXyz expected{ 0.0, 0.0, 0.0 };
+		if(temperatures[i].value >= 0.0) {
+			SpectralRadiance spectrum[CIE_XYZ_SAMPLES];
+			black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, temperatures[i], spectrum);
+			expected = cie_spectrum_to_xyz(spectrum);
+		}
+		const ColorRgb expectedRgb = cie_xyz_to_rgb(expected);
+		EXPECT_EQ(x[i], expected.x);
+		EXPECT_EQ(y[i], expected.y);
+		EXPECT_EQ(z[i], expected.z);
+		EXPECT_EQ(vertices[i].rgb[0], expectedRgb.r);
+		EXPECT_EQ(vertices[i].rgb[1], expectedRgb.g);
+		EXPECT_EQ(vertices[i].rgb[2], expectedRgb.b);
+	}
+}
+
+TEST(black_body_abi_version, matches_header) {
+	EXPECT_EQ(black_body_abi_version() >> 16u, static_cast<unsigned>(BLACKBODY_VERSION_MAJOR));
+	EXPECT_EQ(black_body_abi_version() & 0xFFFFu, static_cast<unsigned>(BLACKBODY_VERSION_MINOR));
+}
+
+TEST(black_body_compute_samples, low_temperature_underflow) {
+	// At a few kelvin the visible spectrum vanishes entirely instead of overflowing the exponential
+	SpectralRadiance samples[CIE_XYZ_SAMPLES];
+	for(const double T : { 0.0, 1.0, 10.0, 20.0 }) {
+		black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, Kelvin{ T }, samples);
+		for(const auto& sample : samples)
+			EXPECT_EQ(sample.value, 0.0);
+	}
+
+	// Across the cutoff the grid kernel matches single samples, none of which are infinite, NaN or denormal
+	SpectralRadiance wide[1000u];
+	for(const double T : { 60.0, 100.0, 300.0, 800.0 }) {
+		black_body_compute_samples(Nanometer{ 100.0 }, Nanometer{ 3000.0 }, 1000u, Kelvin{ T }, wide);
+		for(std::size_t i = 0u; i < 1000u; ++i) {
+			const double lambda = 100.0 + 2900.0 * static_cast<double>(i) / 999.0;
+			const double single = black_body_compute_sample(Nanometer{ lambda }, Kelvin{ T }).value;
+			EXPECT_EQ(wide[i].value, single) << lambda << "nm, " << T << "K";
+			EXPECT_TRUE(single == 0.0 || std::isnormal(single)) << lambda << "nm, " << T << "K";
+		}
+	}
+}
+
+TEST(black_body_compute_sample, accuracy) {
+	// Compare against an extended-precision evaluation, both deep in the Wien tail and in the
+	// Rayleigh-Jeans regime where e^x - 1 cancels
+	const auto reference = [](const long double lambda, const long double T) {
+		const long double x = 6.62607015L * 2.99792458L / (lambda * 1.380649L * T) * 1.0e6L;
+		return 2.0L * 6.62607015L * 2.99792458L * 2.99792458L * 1.0e27L
+			/ (lambda * lambda * lambda * lambda * lambda * std::expm1(x));
+	};
+	const double cases[][2] = {
+		{ 380.0, 300.0 }, { 500.0, 200.0 }, { 830.0, 1000.0 },
+		{ 1.0e6, 10000.0 }, { 1.0e7, 100000.0 }, { 1.0e8, 1.0e6 }
+	};
+	for(const auto& entry : cases) {
+		const double sample = black_body_compute_sample(Nanometer{ entry[0] }, Kelvin{ entry[1] }).value;
+		const double expected = static_cast<double>(reference(entry[0], entry[1]));
+		EXPECT_NEAR(sample, expected, 1.0e-12 * expected) << entry[0] << "nm, " << entry[1] << "K";
+	}
+}
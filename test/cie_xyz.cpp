@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
+#include "blackbody.h"
 #include "cie_xyz.h"
 #include <cmath>
+#include <cstdint>
+#include <vector>
 
 // Check with reasonable precision (4 digits)
 static const double precision = 0.0001;
@@ -60,4 +63,174 @@ TEST(cie_spectrum_to_xyz, triangle_spectrum) {
 	EXPECT_NEAR(xyz.x, 0.765455, precision);
 	EXPECT_NEAR(xyz.y, 0.773947, precision);
 	EXPECT_NEAR(xyz.z, 0.382540, precision);
-}
\ No newline at end of file
+}
+
+TEST(cie_spectra_to_xyz, matches_single_conversion) {
+	// Use an odd count so that both the blocked and the remainder path get exercised
+	const std::size_t count = 7u;
+	std::vector<SpectralRadiance> spectra(count * CIE_XYZ_SAMPLES);
+	std::vector<double> emissivity(count * CIE_XYZ_SAMPLES);
+	std::vector<SpectralRadiance> emitted(count * CIE_XYZ_SAMPLES);
+	for(std::size_t n = 0u; n < count; ++n) {
+		for(std::size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i) {
+			const std::size_t k = n * CIE_XYZ_SAMPLES + i;
+			spectra[k] = SpectralRadiance{ static_cast<double>((i * (n + 3u)) % 17u) };
+			emissivity[k] = 0.25 + 0.7 * static_cast<double>((i * (n + 5u)) % 13u) / 12.0;
+			emitted[k] = SpectralRadiance{ spectra[k].value * emissivity[k] };
+		}
+	}
+
+	std::vector<CieXyz> xyz(count);
+	std::vector<CieXyz> scaled(count);
+	cie_spectra_to_xyz(count, spectra.data(), nullptr, xyz.data());
+	cie_spectra_to_xyz(count, spectra.data(), emissivity.data(), scaled.data());
+	for(std::size_t n = 0u; n < count; ++n) {
+		const CieXyz expected = cie_spectrum_to_xyz(&spectra[n * CIE_XYZ_SAMPLES]);
+		EXPECT_EQ(xyz[n].x, expected.x);
+		EXPECT_EQ(xyz[n].y, expected.y);
+		EXPECT_EQ(xyz[n].z, expected.z);
+		// The emissivity is applied to the samples, which is the same as converting the emitted spectra
+		const CieXyz expectedEmitted = cie_spectrum_to_xyz(&emitted[n * CIE_XYZ_SAMPLES]);
+		EXPECT_EQ(scaled[n].x, expectedEmitted.x);
+		EXPECT_EQ(scaled[n].y, expectedEmitted.y);
+		EXPECT_EQ(scaled[n].z, expectedEmitted.z);
+	}
+}
+
+TEST(cie_table_init, full_resolution_matches_reference) {
+	CieTable table;
+	cie_table_init(&table, CIE_RESOLUTION_1NM);
+	EXPECT_EQ(table.samples, CIE_XYZ_SAMPLES);
+	for(std::size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i) {
+		EXPECT_EQ(table.x[i], CIE_X[i]);
+		EXPECT_EQ(table.y[i], CIE_Y[i]);
+		EXPECT_EQ(table.z[i], CIE_Z[i]);
+	}
+	// The Z response vanishes for the long wavelengths
+	EXPECT_EQ(table.xExtent.end, CIE_XYZ_SAMPLES);
+	EXPECT_EQ(table.zExtent.begin, 0u);
+	EXPECT_EQ(table.zExtent.end, 290u);
+
+	SpectralRadiance spectrum[CIE_XYZ_SAMPLES];
+	black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, Kelvin{ 6500.0 }, spectrum);
+	const CieXyz expected = cie_spectrum_to_xyz(spectrum);
+	const CieXyz xyz = cie_spectrum_to_xyz_table(&table, spectrum);
+	EXPECT_NEAR(xyz.x, expected.x, 1.0e-12 * expected.x);
+	EXPECT_NEAR(xyz.y, expected.y, 1.0e-12 * expected.y);
+	EXPECT_NEAR(xyz.z, expected.z, 1.0e-12 * expected.z);
+}
+
+TEST(cie_table_init, coarse_resolution_error) {
+	// Black bodies from 1000K to blue sky. The worst relative luminance error and
+	// chromaticity (xy) error against the 1nm reference are:
+	//   5nm:  Y < 1.5e-3, xy < 5e-5
+	//   10nm: Y < 6e-3, xy < 2e-4
+	// The chromaticity error is far below what an 8 bit display resolves. The luminance is
+	// overestimated slightly since linear interpolation can't follow the curvature of the
+	// spectrum at low temperatures; above 2000K it stays below 2e-4 (5nm) and 8e-4 (10nm).
+	const struct {
+		CieResolution resolution;
+		std::size_t samples;
+		double luminanceError;
+		double chromaticityError;
+	} cases[] = {
+		{ CIE_RESOLUTION_5NM, 95u, 1.5e-3, 5.0e-5 },
+		{ CIE_RESOLUTION_10NM, 48u, 6.0e-3, 2.0e-4 }
+	};
+
+	for(const auto& c : cases) {
+		CieTable table;
+		cie_table_init(&table, c.resolution);
+		ASSERT_EQ(table.samples, c.samples);
+
+		for(double T = 1000.0; T <= 20000.0; T += 500.0) {
+			SpectralRadiance reference[CIE_XYZ_SAMPLES];
+			SpectralRadiance coarse[CIE_XYZ_SAMPLES];
+			black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, Kelvin{ T }, reference);
+			black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, table.samples, Kelvin{ T }, coarse);
+			const CieXyz expected = cie_spectrum_to_xyz(reference);
+			const CieXyz xyz = cie_spectrum_to_xyz_table(&table, coarse);
+
+			const double expectedSum = expected.x + expected.y + expected.z;
+			const double sum = xyz.x + xyz.y + xyz.z;
+			EXPECT_NEAR(xyz.y / expected.y, 1.0, c.luminanceError) << "T = " << T;
+			EXPECT_NEAR(xyz.x / sum, expected.x / expectedSum, c.chromaticityError) << "T = " << T;
+			EXPECT_NEAR(xyz.y / sum, expected.y / expectedSum, c.chromaticityError) << "T = " << T;
+		}
+	}
+}
+
+TEST(cie_spectrum_to_xyz, accuracy) {
+	// Compare against a long double reference on black bodies and a spectrum with a large dynamic range
+	std::vector<std::vector<SpectralRadiance>> spectra;
+	for(double T = 1000.0; T <= 20000.0; T += 4750.0) {
+		spectra.emplace_back(CIE_XYZ_SAMPLES);
+		black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, Kelvin{ T }, spectra.back().data());
+	}
+	spectra.emplace_back(CIE_XYZ_SAMPLES);
+	for(std::size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i)
+		spectra.back()[i] = SpectralRadiance{ (i % 2u == 0u ? 1.0e12 : 1.0) / static_cast<double>(i + 1u) };
+
+	for(auto& spectrum : spectra) {
+		long double x = 0.0L, y = 0.0L, z = 0.0L;
+		for(std::size_t i = 0u; i < CIE_XYZ_SAMPLES; ++i) {
+			x += static_cast<long double>(CIE_X[i]) * spectrum[i].value;
+			y += static_cast<long double>(CIE_Y[i]) * spectrum[i].value;
+			z += static_cast<long double>(CIE_Z[i]) * spectrum[i].value;
+		}
+		const long double scale = static_cast<long double>(CIE_XYZ_LAMBDA_END.value - CIE_XYZ_LAMBDA_START.value)
+			/ (CIE_Y_INTEGRAL * static_cast<long double>(CIE_XYZ_SAMPLES));
+
+		const CieXyz fast = cie_spectrum_to_xyz(spectrum.data());
+		const CieXyz compensated = cie_spectrum_to_xyz_compensated(spectrum.data());
+		EXPECT_NEAR(fast.x / static_cast<double>(x * scale), 1.0, 1.0e-13);
+		EXPECT_NEAR(fast.y / static_cast<double>(y * scale), 1.0, 1.0e-13);
+		EXPECT_NEAR(fast.z / static_cast<double>(z * scale), 1.0, 1.0e-13);
+		EXPECT_NEAR(compensated.x / static_cast<double>(x * scale), 1.0, 1.0e-15);
+		EXPECT_NEAR(compensated.y / static_cast<double>(y * scale), 1.0, 1.0e-15);
+		EXPECT_NEAR(compensated.z / static_cast<double>(z * scale), 1.0, 1.0e-15);
+	}
+}
+
+TEST(cie_xyz_tables, aligned_and_padded) {
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(CIE_X) % CIE_XYZ_ALIGNMENT, 0u);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(CIE_Y) % CIE_XYZ_ALIGNMENT, 0u);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(CIE_Z) % CIE_XYZ_ALIGNMENT, 0u);
+	EXPECT_EQ(CIE_XYZ_PADDED_SAMPLES * sizeof(double) % CIE_XYZ_ALIGNMENT, 0u);
+	for(std::size_t i = CIE_XYZ_SAMPLES; i < CIE_XYZ_PADDED_SAMPLES; ++i) {
+		EXPECT_EQ(CIE_X[i], 0.0);
+		EXPECT_EQ(CIE_Y[i], 0.0);
+		EXPECT_EQ(CIE_Z[i], 0.0);
+	}
+}
+
+// The last samples are summed together with the padding; only the real samples may contribute
+TEST(cie_spectrum_to_xyz, last_samples) {
+	std::vector<SpectralRadiance> spectrum(CIE_XYZ_SAMPLES, SpectralRadiance{ 0.0 });
+	for(std::size_t i = CIE_XYZ_SAMPLES - 3u; i < CIE_XYZ_SAMPLES; ++i) {
+		spectrum[i].value = 1.0;
+		const CieXyz xyz = cie_spectrum_to_xyz(spectrum.data());
+		EXPECT_GT(xyz.x, 0.0);
+		spectrum[i].value = 0.0;
+	}
+}
+
+TEST(cie_spectra_to_xyz_strided, writes_channels_separately) {
+	const std::size_t count = 5u;
+	std::vector<SpectralRadiance> spectra(count * CIE_XYZ_SAMPLES);
+	for(std::size_t i = 0u; i < spectra.size(); ++i)
+		spectra[i] = SpectralRadiance{ static_cast<double>(i % 23u) };
+
+	std::vector<CieXyz> packed(count);
+	cie_spectra_to_xyz(count, spectra.data(), nullptr, packed.data());
+
+	// Planar layout with the Y channel skipped
+	std::vector<double> x(count, -1.0), z(count, -1.0);
+	const auto stride = static_cast<std::ptrdiff_t>(sizeof(double));
+	const CieXyzView view{ StridedView{ x.data(), stride }, StridedView{ nullptr, 0 }, StridedView{ z.data(), stride } };
+	cie_spectra_to_xyz_strided(count, spectra.data(), nullptr, view);
+	for(std::size_t n = 0u; n < count; ++n) {
+		EXPECT_EQ(x[n], packed[n].x);
+		EXPECT_EQ(z[n], packed[n].z);
+	}
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "field.h"
+#include <cmath>
+#include <vector>
+
+// Converts a frame into planar RGB and returns the number of recomputed cells
+static std::size_t update(BlackBodyField& field, const std::vector<Kelvin>& temperatures,
+						  std::vector<double>& r, std::vector<double>& g, std::vector<double>& b) {
+	const auto stride = static_cast<std::ptrdiff_t>(sizeof(double));
+	const CieXyzView noXyz{ StridedView{ nullptr, 0 }, StridedView{ nullptr, 0 }, StridedView{ nullptr, 0 } };
+	const ColorRgbView rgb{ StridedView{ r.data(), stride }, StridedView{ g.data(), stride }, StridedView{ b.data(), stride } };
+	return black_body_field_update(&field, temperatures.data(), noXyz, rgb);
+}
+
+static ColorRgb exact_color(const Kelvin T) {
+	SpectralRadiance spectrum[CIE_XYZ_SAMPLES];
+	black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, T, spectrum);
+	return cie_xyz_to_rgb(cie_spectrum_to_xyz(spectrum));
+}
+
+TEST(black_body_field_update, recomputes_changed_cells) {
+	const std::size_t cells = 64u;
+	BlackBodyField field;
+	ASSERT_TRUE(black_body_field_init(&field, cells, Kelvin{ 1.0 }, BLACK_BODY_FIELD_HOLD));
+	std::vector<Kelvin> temperatures(cells);
+	for(std::size_t i = 0u; i < cells; ++i)
+		temperatures[i].value = 1000.0 + 100.0 * static_cast<double>(i);
+	std::vector<double> r(cells), g(cells), b(cells);
+
+	// The first frame has nothing to reuse
+	EXPECT_EQ(update(field, temperatures, r, g, b), cells);
+	for(std::size_t i = 0u; i < cells; ++i)
+		EXPECT_EQ(r[i], exact_color(temperatures[i]).r);
+
+	// Small changes keep the color of the reference temperature
+	for(auto& T : temperatures)
+		T.value += 0.5;
+	EXPECT_EQ(update(field, temperatures, r, g, b), 0u);
+	EXPECT_EQ(r[3u], exact_color(Kelvin{ 1300.0 }).r);
+
+	// Changes accumulate against the reference, not the previous frame
+	temperatures[3u].value += 0.75;
+	temperatures[10u].value = 5000.0;
+	temperatures[20u].value = -1.0;
+	temperatures[30u].value = NAN;
+	EXPECT_EQ(update(field, temperatures, r, g, b), 4u);
+	EXPECT_EQ(g[3u], exact_color(temperatures[3u]).g);
+	EXPECT_EQ(g[10u], exact_color(Kelvin{ 5000.0 }).g);
+	EXPECT_EQ(g[20u], 0.0);
+	EXPECT_EQ(g[30u], 0.0);
+
+	// Resetting recomputes everything once more
+	black_body_field_reset(&field);
+	EXPECT_EQ(update(field, temperatures, r, g, b), cells);
+	black_body_field_destroy(&field);
+}
+
+TEST(black_body_field_update, linearized_error) {
+	const std::size_t cells = 10u;
+	const double tolerance = 5.0;
+	BlackBodyField hold, linear;
+	ASSERT_TRUE(black_body_field_init(&hold, cells, Kelvin{ tolerance }, BLACK_BODY_FIELD_HOLD));
+	ASSERT_TRUE(black_body_field_init(&linear, cells, Kelvin{ tolerance }, BLACK_BODY_FIELD_LINEARIZE));
+	std::vector<Kelvin> temperatures(cells);
+	for(std::size_t i = 0u; i < cells; ++i)
+		temperatures[i].value = 1500.0 + 1000.0 * static_cast<double>(i);
+	std::vector<double> r(cells), g(cells), b(cells);
+	update(hold, temperatures, r, g, b);
+	update(linear, temperatures, r, g, b);
+
+	// Drift within the tolerance, comparing the relative error of both modes
+	for(std::size_t frame = 1u; frame <= 4u; ++frame) {
+		for(auto& T : temperatures)
+			T.value += 0.25 * tolerance;
+		std::vector<double> hr(cells), hg(cells), hb(cells);
+		EXPECT_EQ(update(hold, temperatures, hr, hg, hb), 0u);
+		EXPECT_EQ(update(linear, temperatures, r, g, b), 0u);
+		for(std::size_t i = 0u; i < cells; ++i) {
+			const double exact = exact_color(temperatures[i]).g;
+			const double holdError = std::abs(hg[i] - exact) / exact;
+			const double linearError = std::abs(g[i] - exact) / exact;
+			EXPECT_LT(linearError, 2.0e-3) << temperatures[i].value << "K";
+			EXPECT_LT(linearError, 0.1 * holdError) << temperatures[i].value << "K";
+		}
+	}
+
+	// Moving past the tolerance recomputes, which makes the result exact again
+	for(auto& T : temperatures)
+		T.value += 1.0;
+	EXPECT_EQ(update(linear, temperatures, r, g, b), cells);
+	for(std::size_t i = 0u; i < cells; ++i)
+		EXPECT_EQ(b[i], exact_color(temperatures[i]).b);
+
+	black_body_field_destroy(&hold);
+	black_body_field_destroy(&linear);
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "output.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static std::string format_double(const double value) {
+	char buffer[OUTPUT_DOUBLE_MAX_CHARS];
+	const std::size_t length = output_format_double(value, buffer);
+	return std::string(buffer, length);
+}
+
+// Runs the writer against a buffer backed by a temporary file and returns everything written
+template < class Writer >
+static std::string capture(const OutputFormat format, const std::size_t capacity, Writer writer) {
+	FILE* file = std::tmpfile();
+	OutputBuffer output;
+	EXPECT_TRUE(output_init(&output, file, capacity, format));
+	writer(output);
+	output_destroy(&output);
+
+	std::string content(static_cast<std::size_t>(std::ftell(file)), '\0');
+	std::rewind(file);
+	EXPECT_EQ(std::fread(&content[0], 1u, content.size(), file), content.size());
+	std::fclose(file);
+	return content;
+}
+
+TEST(output_format_double, short_values) {
+	EXPECT_EQ(format_double(0.0), "0");
+	EXPECT_EQ(format_double(-0.0), "-0");
+	EXPECT_EQ(format_double(380.0), "380");
+	EXPECT_EQ(format_double(0.1), "0.1");
+	EXPECT_EQ(format_double(-2.5), "-2.5");
+	EXPECT_EQ(format_double(0.001), "0.001");
+	EXPECT_EQ(format_double(123456.75), "123456.75");
+	EXPECT_EQ(format_double(1.0e20), "1e+20");
+	EXPECT_EQ(format_double(1.5e-20), "1.5e-20");
+	EXPECT_EQ(format_double(2.5e-5), "0.000025");
+	EXPECT_EQ(format_double(1.0e16), "10000000000000000");
+	EXPECT_EQ(format_double(9.9999999999999999e22), "1e+23");
+	EXPECT_EQ(format_double(NAN), "nan");
+	EXPECT_EQ(format_double(-INFINITY), "-inf");
+}
+
+TEST(output_format_double, round_trips) {
+	// Values of the magnitudes the calculator produces, plus a few awkward ones
+	const double values[] = {
+		637.82579, 448139.4372896, 4744444883.371235, 409567467583325.69,
+		0.765455, 1.0 / 3.0, 2.0 / 3.0, 1.0e-300, 1.7976931348623157e308, 4.9e-324,
+		3.240479 * 0.765455 - 1.537150 * 0.773947
+	};
+	for(const double value : values) {
+		const std::string str = format_double(value);
+		EXPECT_EQ(std::strtod(str.c_str(), nullptr), value) << str;
+	}
+
+	// Pseudo-random bit patterns across the whole exponent range
+	unsigned long long bits = 0x123456789abcdefull;
+	for(std::size_t i = 0u; i < 100000u; ++i) {
+		bits = bits * 6364136223846793005ull + 1442695040888963407ull;
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		if(!std::isfinite(value))
+			continue;
+		const std::string str = format_double(value);
+		ASSERT_EQ(std::strtod(str.c_str(), nullptr), value) << str;
+	}
+
+	// Sweep over a range of wavelengths as printed for custom ranges
+	for(std::size_t i = 0u; i < 1000u; ++i) {
+		const double value = 380.0 + 450.0 * static_cast<double>(i) / 999.0;
+		const std::string str = format_double(value);
+		EXPECT_EQ(std::strtod(str.c_str(), nullptr), value) << str;
+	}
+}
+
+TEST(output_format_double, shortest) {
+	// The scaled value rounds to a mantissa one off from the nearest 16 digit decimal
+	EXPECT_EQ(format_double(40.881665994175947), "40.88166599417595");
+
+	// Compare the number of significant digits against the fewest that printf needs to round-trip
+	unsigned long long bits = 0xfedcba9876543210ull;
+	for(std::size_t i = 0u; i < 100000u; ++i) {
+		bits = bits * 6364136223846793005ull + 1442695040888963407ull;
+		const double value = 1.0 + static_cast<double>(bits >> 11u) * 0x1.0p-53 * 999.0;
+		char shortest[32];
+		int precision = 1;
+		for(; precision < 17; ++precision) {
+			std::snprintf(shortest, sizeof(shortest), "%.*e", precision - 1, value);
+			if(std::strtod(shortest, nullptr) == value)
+				break;
+		}
+		const std::string str = format_double(value);
+		int digits = 0;
+		for(const char c : str)
+			digits += c >= '0' && c <= '9';
+		ASSERT_EQ(digits, precision) << str;
+	}
+}
+
+TEST(output_write_sample, formats) {
+	const auto write = [](OutputBuffer& output) {
+		output_write_sample(&output, Nanometer{ 380.0 }, SpectralRadiance{ 0.5 });
+		output_write_sample(&output, Nanometer{ 381.5 }, SpectralRadiance{ 2.0 });
+	};
+	EXPECT_EQ(capture(OUTPUT_FORMAT_TEXT, 0u, write), "380nm: 0.5\n381.5nm: 2\n");
+	EXPECT_EQ(capture(OUTPUT_FORMAT_CSV, 0u, write), "wavelength,radiance\n380,0.5\n381.5,2\n");
+	EXPECT_EQ(capture(OUTPUT_FORMAT_NDJSON, 0u, write),
+			  "{\"wavelength\":380,\"radiance\":0.5}\n{\"wavelength\":381.5,\"radiance\":2}\n");
+
+	const std::string binary = capture(OUTPUT_FORMAT_BINARY, 0u, write);
+	ASSERT_EQ(binary.size(), 6u * sizeof(double));
+	double values[6u];
+	std::memcpy(values, binary.data(), binary.size());
+	EXPECT_EQ(values[0u], static_cast<double>(OUTPUT_RECORD_SAMPLE));
+	EXPECT_EQ(values[1u], 380.0);
+	EXPECT_EQ(values[2u], 0.5);
+	EXPECT_EQ(values[3u], static_cast<double>(OUTPUT_RECORD_SAMPLE));
+	EXPECT_EQ(values[4u], 381.5);
+	EXPECT_EQ(values[5u], 2.0);
+}
+
+TEST(output_write_normalized_sample, distinct_from_samples) {
+	const auto write = [](OutputBuffer& output) {
+		output_write_sample(&output, Nanometer{ 400.0 }, SpectralRadiance{ 4.0 });
+		output_write_normalized_sample(&output, Nanometer{ 400.0 }, SpectralRadiance{ 1.0 });
+	};
+	EXPECT_EQ(capture(OUTPUT_FORMAT_CSV, 0u, write),
+			  "wavelength,radiance\n400,4\nwavelength,normalized_radiance\n400,1\n");
+	EXPECT_EQ(capture(OUTPUT_FORMAT_NDJSON, 0u, write),
+			  "{\"wavelength\":400,\"radiance\":4}\n{\"wavelength\":400,\"normalizedRadiance\":1}\n");
+
+	const std::string binary = capture(OUTPUT_FORMAT_BINARY, 0u, write);
+	ASSERT_EQ(binary.size(), 6u * sizeof(double));
+	double values[6u];
+	std::memcpy(values, binary.data(), binary.size());
+	EXPECT_EQ(values[0u], static_cast<double>(OUTPUT_RECORD_SAMPLE));
+	EXPECT_EQ(values[3u], static_cast<double>(OUTPUT_RECORD_NORMALIZED_SAMPLE));
+	EXPECT_EQ(values[5u], 1.0);
+}
+
+TEST(output_write_color, formats) {
+	const auto write = [](OutputBuffer& output) {
+		output_write_color(&output, Kelvin{ 6500.0 }, CieXyz{ 1.0, 0.5, 0.25 },
+						   ColorRgb{ 2.0, 1.0, 0.5 }, ColorRgb{ 1.0, 0.5, 0.25 });
+	};
+	EXPECT_EQ(capture(OUTPUT_FORMAT_TEXT, 0u, write),
+			  "Black-body color for 6500K:\nXYZ:\t\t\t[ 1, 0.5, 0.25 ]\nRGB:\t\t\t[ 2, 1, 0.5 ]\n"
+			  "RGB(normalized):\t[ 1, 0.5, 0.25 ]\n");
+	EXPECT_EQ(capture(OUTPUT_FORMAT_CSV, 0u, write),
+			  "temperature,x,y,z,r,g,b,r_normalized,g_normalized,b_normalized\n6500,1,0.5,0.25,2,1,0.5,1,0.5,0.25\n");
+	EXPECT_EQ(capture(OUTPUT_FORMAT_NDJSON, 0u, write),
+			  "{\"temperature\":6500,\"xyz\":[1,0.5,0.25],\"rgb\":[2,1,0.5],\"rgbNormalized\":[1,0.5,0.25]}\n");
+	EXPECT_EQ(capture(OUTPUT_FORMAT_BINARY, 0u, write).size(), 11u * sizeof(double));
+}
+
+TEST(output_write_sample, flushes_small_buffer) {
+	// A buffer that can barely hold a record has to flush repeatedly without losing anything
+	const auto write = [](OutputBuffer& output) {
+		for(std::size_t i = 0u; i < 10000u; ++i)
+			output_write_sample(&output, Nanometer{ static_cast<double>(i) }, SpectralRadiance{ 1.0 });
+	};
+	const std::string content = capture(OUTPUT_FORMAT_CSV, 1u, write);
+	EXPECT_EQ(content, capture(OUTPUT_FORMAT_CSV, 0u, write));
+	EXPECT_EQ(content.substr(content.size() - 7u), "9999,1\n");
+}
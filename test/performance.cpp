@@ -0,0 +1,276 @@
+// Performance regression check for the spectrum, XYZ (single, batched, and with coarse tables), and RGB stages.
+// Every stage's cost is measured relative to a calibration loop so the numbers carry over between machines,
+// and compared against the baseline stored in test/perf_baseline.json.
+//
+// Usage: PerformanceTest --baseline FILE [--threshold T] [--update-baseline]
+//   --threshold T        Allowed relative slowdown per stage before failing (default 1.0, i.e. twice as slow);
+//                        without the argument it is read from the environment variable BLACKBODY_PERF_THRESHOLD
+//   --update-baseline    Writes the measured costs to the baseline file instead of comparing against it
+#include "blackbody.h"
+#include "cie_xyz.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Returned when the measurements would be meaningless (registered as SKIP_RETURN_CODE with CTest)
+static const int SKIP_CODE = 77;
+// Every measurement is repeated and the fastest run is kept, which is the one least disturbed by the system
+static const std::size_t REPETITIONS = 15u;
+static const std::size_t TEMPERATURES = 256u;
+static const char* const STAGES[] = { "spectrum", "xyz", "xyz_batch", "xyz_5nm", "xyz_10nm", "rgb" };
+// Indices of the single and batched XYZ conversions, which are compared against each other
+static const std::size_t XYZ_STAGE = 1u;
+static const std::size_t XYZ_BATCH_STAGE = 2u;
+// Indices of the conversions with the coarse tables of cie_table_init, for 5nm and 10nm
+static const std::size_t XYZ_COARSE_STAGE = 3u;
+static const std::size_t STAGE_COUNT = sizeof(STAGES) / sizeof(STAGES[0]);
+
+// Keeps the compiler from discarding the measured work
+static volatile double sink;
+// Start of the calibration loop, read at run time so the compiler can't compute the loop in advance
+static volatile double calibrationStart = 1.0;
+// The calibration loop takes milliseconds on any current machine; a much faster run means it was optimized away
+static const double MIN_CALIBRATION_SECONDS = 1.0e-4;
+
+// Returns the fastest of several runs of the workload in seconds
+template < class Workload >
+static double measure(Workload workload) {
+	double fastest = INFINITY;
+	for(std::size_t i = 0u; i < REPETITIONS; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		sink = workload();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fastest = std::min(fastest, elapsed.count());
+	}
+	return fastest;
+}
+
+// Like measure, but alternates between both workloads so that a disturbance of the system affects them alike;
+// returns the fastest run of each
+template < class First, class Second >
+static std::pair<double, double> measure_interleaved(First first, Second second) {
+	std::pair<double, double> fastest(INFINITY, INFINITY);
+	for(std::size_t i = 0u; i < 4u * REPETITIONS; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		sink = first();
+		const std::chrono::duration<double> firstElapsed = std::chrono::steady_clock::now() - start;
+		start = std::chrono::steady_clock::now();
+		sink = second();
+		const std::chrono::duration<double> secondElapsed = std::chrono::steady_clock::now() - start;
+		fastest.first = std::min(fastest.first, firstElapsed.count());
+		fastest.second = std::min(fastest.second, secondElapsed.count());
+	}
+	return fastest;
+}
+
+// A fixed mix of transcendental and arithmetic operations, similar to what the stages consist of
+static double calibrate() {
+	return measure([]() {
+		const double start = calibrationStart;
+		double sum = 0.0;
+		for(std::size_t i = 0u; i < 200000u; ++i) {
+			const double x = start + static_cast<double>(i & 1023u) * 1.0e-2;
+			sum += 1.0 / (x * x * x * x * x * (std::exp(x) - 1.0)) + 0.5 * x;
+		}
+		return sum;
+	});
+}
+
+// Measures the time of every stage per processed temperature, relative to the calibration loop
+static std::vector<double> measure_stages(const double calibration) {
+	std::vector<Kelvin> temperatures(TEMPERATURES);
+	for(std::size_t i = 0u; i < TEMPERATURES; ++i)
+		temperatures[i].value = 1000.0 + 11000.0 * static_cast<double>(i) / static_cast<double>(TEMPERATURES - 1u);
+	std::vector<SpectralRadiance> spectra(TEMPERATURES * CIE_XYZ_SAMPLES);
+	std::vector<CieXyz> colors(TEMPERATURES);
+
+	std::vector<double> seconds;
+	seconds.push_back(measure([&]() {
+		for(std::size_t i = 0u; i < TEMPERATURES; ++i)
+			black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, temperatures[i],
+									   &spectra[i * CIE_XYZ_SAMPLES]);
+		return spectra[TEMPERATURES * CIE_XYZ_SAMPLES - 1u].value;
+	}));
+	// The conversions are much cheaper than sampling, so they are repeated to get measurable times
+	const std::size_t xyzRounds = 16u;
+	// The single and batched conversions are compared against each other, so they are measured side by side
+	const auto single = [&]() {
+		double sum = 0.0;
+		for(std::size_t round = 0u; round < xyzRounds; ++round) {
+			for(std::size_t i = 0u; i < TEMPERATURES; ++i) {
+				colors[i] = cie_spectrum_to_xyz(&spectra[i * CIE_XYZ_SAMPLES]);
+				sum += colors[i].y;
+			}
+		}
+		return sum;
+	};
+	const auto batched = [&]() {
+		double sum = 0.0;
+		for(std::size_t round = 0u; round < xyzRounds; ++round) {
+			cie_spectra_to_xyz(TEMPERATURES, spectra.data(), NULL, colors.data());
+			sum += colors[TEMPERATURES - 1u].y;
+		}
+		return sum;
+	};
+	const std::pair<double, double> xyz = measure_interleaved(single, batched);
+	seconds.push_back(xyz.first / static_cast<double>(xyzRounds));
+	seconds.push_back(xyz.second / static_cast<double>(xyzRounds));
+	// The coarse tables visit 95 (5nm) and 48 (10nm) instead of 471 samples, on correspondingly coarser spectra
+	const CieResolution resolutions[] = { CIE_RESOLUTION_5NM, CIE_RESOLUTION_10NM };
+	for(const CieResolution resolution : resolutions) {
+		CieTable table;
+		cie_table_init(&table, resolution);
+		std::vector<SpectralRadiance> coarse(TEMPERATURES * table.samples);
+		for(std::size_t i = 0u; i < TEMPERATURES; ++i)
+			black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, table.samples, temperatures[i],
+									   &coarse[i * table.samples]);
+		seconds.push_back(measure([&]() {
+			double sum = 0.0;
+			for(std::size_t round = 0u; round < xyzRounds; ++round) {
+				for(std::size_t i = 0u; i < TEMPERATURES; ++i)
+					sum += cie_spectrum_to_xyz_table(&table, &coarse[i * table.samples]).y;
+			}
+			return sum;
+		}) / static_cast<double>(xyzRounds));
+	}
+	const std::size_t rgbRounds = 1024u;
+	seconds.push_back(measure([&]() {
+		double sum = 0.0;
+		for(std::size_t round = 0u; round < rgbRounds; ++round) {
+			for(std::size_t i = 0u; i < TEMPERATURES; ++i)
+				sum += cie_xyz_to_rgb(colors[i]).g;
+		}
+		return sum;
+	}) / static_cast<double>(rgbRounds));
+
+	std::vector<double> costs;
+	for(const double stage : seconds)
+		costs.push_back(stage / static_cast<double>(TEMPERATURES) / calibration);
+	return costs;
+}
+
+// Reads the stage costs from the baseline; only the subset of JSON written by write_baseline is understood
+static bool read_baseline(const char* path, std::vector<double>& costs) {
+	std::ifstream file(path);
+	if(!file)
+		return false;
+	std::stringstream content;
+	content << file.rdbuf();
+	const std::string json = content.str();
+
+	costs.clear();
+	for(std::size_t i = 0u; i < STAGE_COUNT; ++i) {
+		const std::size_t key = json.find(std::string("\"") + STAGES[i] + "\"");
+		const std::size_t colon = key == std::string::npos ? key : json.find(':', key);
+		if(colon == std::string::npos)
+			return false;
+		char* end;
+		const double cost = std::strtod(json.c_str() + colon + 1u, &end);
+		if(end == json.c_str() + colon + 1u || !(cost > 0.0))
+			return false;
+		costs.push_back(cost);
+	}
+	return true;
+}
+
+// Parses a threshold, which has to be a positive number without trailing characters
+static bool parse_threshold(const char* text, double& threshold) {
+	char* end;
+	const double value = std::strtod(text, &end);
+	if(end == text || *end != '\0' || !(value > 0.0) || !std::isfinite(value))
+		return false;
+	threshold = value;
+	return true;
+}
+
+static bool write_baseline(const char* path, const std::vector<double>& costs) {
+	FILE* file = std::fopen(path, "w");
+	if(file == NULL)
+		return false;
+	std::fprintf(file, "{\n\t\"unit\": \"time per temperature relative to the calibration loop\",\n\t\"stages\": {\n");
+	for(std::size_t i = 0u; i < STAGE_COUNT; ++i)
+		std::fprintf(file, "\t\t\"%s\": %.6g%s\n", STAGES[i], costs[i], i + 1u < STAGE_COUNT ? "," : "");
+	std::fprintf(file, "\t}\n}\n");
+	return std::fclose(file) == 0;
+}
+
+int main(int argc, char* argv[]) {
+	const char* baselinePath = NULL;
+	bool update = false;
+	const char* thresholdText = std::getenv("BLACKBODY_PERF_THRESHOLD");
+	for(int i = 1; i < argc; ++i) {
+		if(std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+			baselinePath = argv[++i];
+		} else if(std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+			thresholdText = argv[++i];
+		} else if(std::strcmp(argv[i], "--update-baseline") == 0) {
+			update = true;
+		} else {
+			std::fprintf(stderr, "Unknown argument '%s'\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+	}
+	if(baselinePath == NULL) {
+		std::fprintf(stderr, "Usage: %s --baseline FILE [--threshold T] [--update-baseline]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	double threshold = 1.0;
+	if(thresholdText != NULL && !parse_threshold(thresholdText, threshold)) {
+		std::fprintf(stderr, "Invalid threshold '%s': expected a positive number\n", thresholdText);
+		return EXIT_FAILURE;
+	}
+
+#ifndef BLACKBODY_PERF_OPTIMIZED
+	// The baseline is recorded with optimizations; unoptimized builds have entirely different relative costs
+	std::printf("Skipping performance check: build is not optimized\n");
+	return SKIP_CODE;
+#endif // BLACKBODY_PERF_OPTIMIZED
+
+	const double calibration = calibrate();
+	if(!(calibration >= MIN_CALIBRATION_SECONDS)) {
+		std::fprintf(stderr, "Calibration loop took only %.3g s; the measurements would be meaningless\n", calibration);
+		return EXIT_FAILURE;
+	}
+	const std::vector<double> costs = measure_stages(calibration);
+	// The speedups are only reported; like every stage, the batched conversion is checked against its baseline
+	std::printf("Batched XYZ conversion: %.2fx the speed of single conversions\n", costs[XYZ_STAGE] / costs[XYZ_BATCH_STAGE]);
+	std::printf("Coarse XYZ tables: %.2fx (5nm) and %.2fx (10nm) the speed of the full table\n",
+				costs[XYZ_STAGE] / costs[XYZ_COARSE_STAGE], costs[XYZ_STAGE] / costs[XYZ_COARSE_STAGE + 1u]);
+	if(update) {
+		if(!write_baseline(baselinePath, costs)) {
+			std::fprintf(stderr, "Failed to write baseline '%s'\n", baselinePath);
+			return EXIT_FAILURE;
+		}
+		for(std::size_t i = 0u; i < STAGE_COUNT; ++i)
+			std::printf("%-10s %10.4g\n", STAGES[i], costs[i]);
+		std::printf("Baseline written to '%s'\n", baselinePath);
+		return EXIT_SUCCESS;
+	}
+
+	std::vector<double> baseline;
+	if(!read_baseline(baselinePath, baseline)) {
+		std::fprintf(stderr, "Failed to read baseline '%s'\n", baselinePath);
+		return EXIT_FAILURE;
+	}
+
+	bool regressed = false;
+	std::printf("%-10s %10s %10s %9s\n", "stage", "baseline", "measured", "change");
+	for(std::size_t i = 0u; i < STAGE_COUNT; ++i) {
+		const double change = costs[i] / baseline[i] - 1.0;
+		const bool failed = change > threshold;
+		regressed = regressed || failed;
+		std::printf("%-10s %10.4g %10.4g %+8.1f%%%s\n", STAGES[i], baseline[i], costs[i], 100.0 * change,
+					failed ? "  REGRESSION" : "");
+	}
+	if(regressed)
+		std::printf("At least one stage is more than %.0f%% slower than the baseline\n", 100.0 * threshold);
+	return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
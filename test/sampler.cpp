@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include "blackbody.h"
+#include "sampler.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Width of a bin as used by the sampler
+static const double width = (CIE_XYZ_LAMBDA_END.value - CIE_XYZ_LAMBDA_START.value) / BLACK_BODY_SAMPLER_BINS;
+
+// Trapezoidal integral of the (optionally luminance-weighted) spectrum over the CIE range
+static double integrate_spectrum(const Kelvin T, const BlackBodySamplerWeight weight) {
+	SpectralRadiance spectrum[CIE_XYZ_SAMPLES];
+	black_body_compute_samples(CIE_XYZ_LAMBDA_START, CIE_XYZ_LAMBDA_END, CIE_XYZ_SAMPLES, T, spectrum);
+	double integral = 0.0;
+	for(std::size_t i = 0u; i < BLACK_BODY_SAMPLER_BINS; ++i) {
+		double a = spectrum[i].value;
+		double b = spectrum[i + 1u].value;
+		if(weight == BLACK_BODY_SAMPLER_LUMINANCE) {
+			a *= CIE_Y[i];
+			b *= CIE_Y[i + 1u];
+		}
+		integral += 0.5 * (a + b) * width;
+	}
+	return integral;
+}
+
+TEST(black_body_sampler_init, pdf_is_normalized) {
+	const BlackBodySamplerWeight weights[] = { BLACK_BODY_SAMPLER_RADIANCE, BLACK_BODY_SAMPLER_LUMINANCE };
+	for(const auto weight : weights) {
+		for(double T = 1000.0; T <= 10000.0; T += 3000.0) {
+			BlackBodySampler sampler;
+			EXPECT_TRUE(black_body_sampler_init(&sampler, Kelvin{ T }, weight));
+			double total = 0.0;
+			for(std::size_t i = 0u; i < BLACK_BODY_SAMPLER_BINS; ++i)
+				total += sampler.pdf[i] * width;
+			EXPECT_NEAR(total, 1.0, 1.0e-12);
+		}
+	}
+
+	// A vanishing spectrum falls back to uniform sampling
+	BlackBodySampler sampler;
+	EXPECT_FALSE(black_body_sampler_init(&sampler, Kelvin{ 0.0 }, BLACK_BODY_SAMPLER_RADIANCE));
+	EXPECT_NEAR(black_body_sampler_pdf(&sampler, Nanometer{ 500.0 }), 1.0 / 450.0, 1.0e-12);
+	EXPECT_EQ(black_body_sampler_pdf(&sampler, Nanometer{ 300.0 }), 0.0);
+}
+
+TEST(black_body_sampler_draw, histogram_matches_pdf) {
+	BlackBodySampler sampler;
+	black_body_sampler_init(&sampler, Kelvin{ 2000.0 }, BLACK_BODY_SAMPLER_LUMINANCE);
+
+	std::mt19937_64 rng(1234u);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	const std::size_t count = 1000000u;
+	std::vector<double> u(2u * count);
+	for(auto& value : u)
+		value = uniform(rng);
+	std::vector<WavelengthSample> samples(count);
+	black_body_sampler_draw_batch(&sampler, count, u.data(), samples.data());
+
+	std::vector<double> histogram(BLACK_BODY_SAMPLER_BINS, 0.0);
+	for(const auto& sample : samples) {
+		ASSERT_GE(sample.wavelength.value, CIE_XYZ_LAMBDA_START.value);
+		ASSERT_LE(sample.wavelength.value, CIE_XYZ_LAMBDA_END.value);
+		EXPECT_EQ(sample.pdf, black_body_sampler_pdf(&sampler, sample.wavelength));
+		const auto bin = static_cast<std::size_t>((sample.wavelength.value - CIE_XYZ_LAMBDA_START.value) / width);
+		histogram[bin < BLACK_BODY_SAMPLER_BINS ? bin : BLACK_BODY_SAMPLER_BINS - 1u] += 1.0;
+	}
+	for(std::size_t i = 0u; i < BLACK_BODY_SAMPLER_BINS; ++i) {
+		// Allow for five standard deviations of the binomial distribution
+		const double expected = sampler.pdf[i] * width * static_cast<double>(count);
+		EXPECT_NEAR(histogram[i], expected, 5.0 * std::sqrt(expected) + 1.0) << "bin " << i;
+	}
+}
+
+TEST(black_body_sampler_draw, unbiased_estimate) {
+	// Estimating the integral of the spectrum with importance sampling has to converge to the exact value;
+	// since the pdf follows the spectrum closely the variance is tiny
+	const Kelvin T{ 4000.0 };
+	BlackBodySampler sampler;
+	black_body_sampler_init(&sampler, T, BLACK_BODY_SAMPLER_RADIANCE);
+
+	std::mt19937_64 rng(42u);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	double estimate = 0.0;
+	const std::size_t count = 100000u;
+	for(std::size_t i = 0u; i < count; ++i) {
+		const WavelengthSample sample = black_body_sampler_draw(&sampler, uniform(rng), uniform(rng));
+		estimate += black_body_compute_sample(sample.wavelength, T).value / sample.pdf;
+	}
+	estimate /= static_cast<double>(count);
+
+	const double reference = integrate_spectrum(T, BLACK_BODY_SAMPLER_RADIANCE);
+	EXPECT_NEAR(estimate / reference, 1.0, 1.0e-3);
+}
+
+TEST(black_body_sampler_set, interpolates_temperatures) {
+	BlackBodySamplerSet set;
+	ASSERT_TRUE(black_body_sampler_set_init(&set, Kelvin{ 1000.0 }, Kelvin{ 11000.0 }, 11u, BLACK_BODY_SAMPLER_LUMINANCE));
+
+	// On a table's temperature the set behaves like that table
+	BlackBodySampler sampler;
+	black_body_sampler_init(&sampler, Kelvin{ 3000.0 }, BLACK_BODY_SAMPLER_LUMINANCE);
+	for(double lambda = 380.0; lambda <= 830.0; lambda += 10.0)
+		EXPECT_NEAR(black_body_sampler_set_pdf(&set, Kelvin{ 3000.0 }, Nanometer{ lambda }),
+					black_body_sampler_pdf(&sampler, Nanometer{ lambda }), 1.0e-12);
+	const WavelengthSample single = black_body_sampler_draw(&sampler, 0.3, 0.6);
+	const WavelengthSample fromSet = black_body_sampler_set_draw(&set, Kelvin{ 3000.0 }, 0.3, 0.6, 0.5);
+	EXPECT_EQ(single.wavelength.value, fromSet.wavelength.value);
+	EXPECT_NEAR(single.pdf, fromSet.pdf, 1.0e-12);
+
+	// In between the reported pdf is the one of the mixture, which keeps the estimate unbiased
+	const Kelvin T{ 3250.0 };
+	std::mt19937_64 rng(7u);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	const std::size_t count = 200000u;
+	std::vector<Kelvin> temperatures(count, T);
+	std::vector<double> u(3u * count);
+	for(auto& value : u)
+		value = uniform(rng);
+	std::vector<WavelengthSample> samples(count);
+	black_body_sampler_set_draw_batch(&set, count, temperatures.data(), u.data(), samples.data());
+
+	double estimate = 0.0;
+	for(const auto& sample : samples) {
+		EXPECT_NEAR(sample.pdf, black_body_sampler_set_pdf(&set, T, sample.wavelength), 1.0e-12);
+		const auto bin = static_cast<std::size_t>((sample.wavelength.value - CIE_XYZ_LAMBDA_START.value) / width);
+		const double luminance = black_body_compute_sample(sample.wavelength, T).value
+			* CIE_Y[bin < BLACK_BODY_SAMPLER_BINS ? bin : BLACK_BODY_SAMPLER_BINS - 1u];
+		estimate += luminance / sample.pdf;
+	}
+	estimate /= static_cast<double>(count);
+	EXPECT_NEAR(estimate / integrate_spectrum(T, BLACK_BODY_SAMPLER_LUMINANCE), 1.0, 2.0e-2);
+
+	black_body_sampler_set_destroy(&set);
+}